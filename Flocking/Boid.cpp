@@ -3,30 +3,47 @@
 
 #include <iostream>
 
-Entity::Entity(float acceleration, float rotate_speed)
+Entity::Entity()
 	: m_state(0)
 	, thrust_ratio(1.f)
 	, rotate_ratio_left(1.f)
 	, rotate_ratio_right(1.f)
-	, m_acceleration(acceleration)
-	, m_rotate_speed(rotate_speed)
 	, m_speed(0)
 { }
 
+const sf::Vector2f& Entity::getPosition() const
+{
+	return m_position;
+}
+
+void Entity::setPosition(sf::Vector2f position)
+{
+	m_position = position;
+}
+
+const Utilise::Heading& Entity::getHeading() const
+{
+	return m_heading;
+}
+
+void Entity::setHeading(const Utilise::Heading& heading)
+{
+	m_heading = heading;
+}
+
+sf::Transform Entity::getTransform() const
+{
+	return m_heading.getTransform(m_position);
+}
+
 sf::Vector2f Entity::globalToLocal(sf::Vector2f point) const
 {
-	float rot = Utilise::toRadian(getRotation());
-	return sf::Vector2f(
-		point.x * std::cos(rot) + point.y * std::sin(rot),
-		point.y * std::cos(rot) - point.x * std::sin(rot));
+	return m_heading.toLocal(point);
 }
 
 sf::Vector2f Entity::localToGlobal(sf::Vector2f point) const
 {
-	float rot = Utilise::toRadian(-1.f * getRotation());
-	return sf::Vector2f(
-		point.x * std::cos(rot) + point.y * std::sin(rot),
-		point.y * std::cos(rot) - point.x * std::sin(rot));
+	return m_heading.toGlobal(point);
 }
 
 sf::Vector2f Entity::getVelocity() const
@@ -34,35 +51,48 @@ sf::Vector2f Entity::getVelocity() const
 	return localToGlobal(sf::Vector2f(0.f, m_speed));
 }
 
-void Entity::update(sf::Time dt)
+float Entity::getSpeed() const
 {
+	return m_speed;
+}
+
+void Entity::setSpeed(float speed)
+{
+	m_speed = speed;
+}
+
+int Entity::getState() const
+{
+	return m_state;
+}
+
+void Entity::update(sf::Time dt, float acceleration, float rotate_speed)
+{
+	// Both sides are folded into a single rotation, built once per tick
+	float angle = 0.f;
 	if (m_state & RIGHT)
-		rotate(rotate_ratio_right * m_rotate_speed * dt.asSeconds());
+		angle += rotate_ratio_right * rotate_speed * dt.asSeconds();
 	if (m_state & LEFT)
-		rotate(-rotate_ratio_left * m_rotate_speed * dt.asSeconds());
+		angle -= rotate_ratio_left * rotate_speed * dt.asSeconds();
+	if (angle != 0.f)
+		m_heading.rotate(Utilise::Rotation(angle));
 	if (m_state & THRUST)
-		m_speed += m_acceleration * thrust_ratio * dt.asSeconds();
+		m_speed += acceleration * thrust_ratio * dt.asSeconds();
 	m_speed -= DRAG_CONST * m_speed * m_speed * dt.asSeconds();
 	m_speed = std::max(0.f, m_speed);
-	move(getVelocity() * dt.asSeconds());
+	m_position += getVelocity() * dt.asSeconds();
 }
 
-Boid::Boid(float acceleration, float rotate_speed, 
-	float radius, float angle, float feeler_length, float feeler_angle)
-	: Entity(acceleration, rotate_speed)
-	, m_view_radius(radius)
-	, m_view_angle(angle)
-	, m_feeler_length(feeler_length)
-	, m_feeler_angle(feeler_angle)
-	, m_body(sf::Triangles, 3)
-{ 
-	m_body[0].position = sf::Vector2f(0, 5);
-	m_body[1].position = sf::Vector2f(-2.5f, -2);
-	m_body[2].position = sf::Vector2f(2.5f, - 2);
+Boid::Boid(std::uint16_t archetype)
+	: m_archetype(archetype)
+	, m_steer_state(NONE)
+	, m_steer_left(0.f)
+	, m_steer_right(0.f)
+{ }
 
-	sf::Color c(rand() % 256, rand() % 256, rand() % 256);
-	for (int i = 0; i < 3; i++)
-		m_body[i].color = c;
+std::uint16_t Boid::getArchetype() const
+{
+	return m_archetype;
 }
 
 void Boid::setThruster(bool enable, float ratio)
@@ -97,103 +127,92 @@ void Boid::turnOff()
 	m_state &= ~RIGHT;
 }
 
-void Boid::updateData(const std::vector<Boid*>& boids)
+int Boid::updateData(const BoidStore& store, int self, Grid::Range neighbours, const BoidArchetype& type)
+{
+	NeighbourSums sums = store.accumulate(self, neighbours.first, neighbours.last, type.cone);
+	if (sums.count != 0)
+		steer(sums);
+	m_steer_state = m_state & (LEFT | RIGHT);
+	m_steer_left = rotate_ratio_left;
+	m_steer_right = rotate_ratio_right;
+	return sums.count;
+}
+
+void Boid::reuseSteering()
+{
+	m_state |= m_steer_state;
+	rotate_ratio_left = m_steer_left;
+	rotate_ratio_right = m_steer_right;
+}
+
+void Boid::steer(const NeighbourSums& sums)
 {
-	float left = 0.f, right = 0.f;
-	std::vector<Boid*> visible_units;
-	for (Boid* i : boids)
-	{
-		sf::Vector2f dis = globalToLocal(i->getPosition() - getPosition());
-		float lth = Utilise::lengthOf(dis);
-		if (lth <= m_view_radius && i != this)
-		{
-			if (m_view_angle <= 90 && dis.y >= 0)
-			{
-				if (abs(dis.x) <= m_view_radius * std::sin(Utilise::toRadian(m_view_angle)))
-					visible_units.push_back(i);
-			}
-
-			else if (m_view_angle > 90)
-			{
-				if (dis.y >= 0)
-					visible_units.push_back(i);
-				else if (abs(dis.y) <= m_view_radius * std::cos(Utilise::toRadian(180 - m_view_angle)))
-					visible_units.push_back(i);
-			}
-		}
-	}
 	// Separation
-	sf::Vector2f steer;
-	for (Boid* i : visible_units)
-	{
-		sf::Vector2f dis = i->getPosition() - getPosition();
-		float lth = Utilise::lengthOf(dis);
-		if (2.5 * lth <= m_view_radius)
-		{
-			dis = globalToLocal(dis);
-			if (dis.x > 0)
-				turn(false, 0.2f * m_view_radius / (2.5f * lth));
-			else
-				turn(true, 0.2f * m_view_radius / (2.5f * lth));
-		}
-	}
+	if (sums.separation_right > 0)
+		turn(false, sums.separation_right);
+	if (sums.separation_left > 0)
+		turn(true, sums.separation_left);
 	// Alignment
-	sf::Vector2f vel;
-	for (Boid* i : visible_units)
-		vel += i->getVelocity();
-	if (visible_units.size())
-	{
-		vel = vel / (1.f * visible_units.size());
-		sf::Vector2f dir_norm = Utilise::normalise(getVelocity());
-		vel = Utilise::normalise(vel);
-		float prod = dir_norm.x * vel.x + dir_norm.y * vel.y;
-		float frac = std::acos(std::min(1.f, std::max(-1.f, prod))) / Utilise::PI;
-		if (globalToLocal(vel).x < 0)
-			turn(false, frac);
-		else
-			turn(true, frac);
-	}
+	sf::Vector2f dir_norm = Utilise::normalise(getVelocity());
+	sf::Vector2f vel = Utilise::normalise(sums.velocity / (1.f * sums.count));
+	float prod = dir_norm.x * vel.x + dir_norm.y * vel.y;
+	float frac = std::acos(std::min(1.f, std::max(-1.f, prod))) / Utilise::PI;
+	if (globalToLocal(vel).x < 0)
+		turn(false, frac);
+	else
+		turn(true, frac);
 
 	// Cohesion
-	sf::Vector2f pos;
-	for (Boid* i : visible_units)
-		pos += i->getPosition();
-	if (visible_units.size())
-	{
-		pos = pos / (1.f * visible_units.size());
-		sf::Vector2f dir_norm = Utilise::normalise(getVelocity());
-		sf::Vector2f dis_norm = Utilise::normalise(pos - getPosition());
-		float prod = dir_norm.x * dis_norm.x + dir_norm.y * dis_norm.y;
-		float frac = std::acos(std::min(1.f, std::max(-1.f, prod))) / Utilise::PI;
-		if (globalToLocal(dis_norm).x < 0)
-			turn(false, frac);
-		else
-			turn(true, frac);
-	}
+	// Direction to the centre of the neighbours, measured across the edges of the world
+	sf::Vector2f dis_norm = Utilise::normalise(sums.offset / (1.f * sums.count));
+	prod = dir_norm.x * dis_norm.x + dir_norm.y * dis_norm.y;
+	frac = std::acos(std::min(1.f, std::max(-1.f, prod))) / Utilise::PI;
+	if (globalToLocal(dis_norm).x < 0)
+		turn(false, frac);
+	else
+		turn(true, frac);
 }
 
-void Boid::updateFeeler(const std::vector<std::unique_ptr<Obstacle>>& obstacles)
+void Boid::updateFeeler(const ObstacleTree& obstacles, const BoidArchetype& type)
 {
-	float left = 2.f, right = 2.f;
-	float angle = Utilise::toRadian(m_feeler_angle);
-	sf::Vector2f antenna(m_feeler_length * std::sin(angle), m_feeler_length * std::cos(angle));
+	float left = 2.f, right = 2.f, time;
+	sf::Vector2f antenna = type.antenna;
 	sf::Vector2f left_feeler = localToGlobal(antenna);
-	for (int i = 0; i < obstacles.size(); i++)
-	{
-		bool collide = false;
-		float time = obstacles[i]->checkRay(getPosition(), getPosition() + left_feeler, collide);
-		if (collide)
-			left = std::min(left, time);
-	}
+	if (obstacles.raycast(getPosition(), getPosition() + left_feeler, time))
+		left = std::min(left, time);
 	antenna.x *= -1.f;
 	sf::Vector2f right_feeler = localToGlobal(antenna);
-	for (int i = 0; i < obstacles.size(); i++)
+	if (obstacles.raycast(getPosition(), getPosition() + right_feeler, time))
+		right = std::min(right, time);
+	avoid(left, right);
+}
+
+void Boid::updateFeeler(const DistanceField& field, const ObstacleTree& obstacles, const BoidArchetype& type)
+{
+	float clearance = field.distance(getPosition());
+	if (clearance >= type.antenna_length)
+		return;
+	// Touching or inside an obstacle, where a feeler would hit at 0
+	if (clearance <= 0.5f * field.getTexelSize())
 	{
-		bool collide = false;
-		float time = obstacles[i]->checkRay(getPosition(), getPosition() + right_feeler, collide);
-		if (collide)
-			right = std::min(right, time);
+		if (globalToLocal(field.gradient(getPosition())).x < 0)
+			turn(false, 1.f);
+		else
+			turn(true, 1.f);
+		return;
 	}
+	float left = 2.f, right = 2.f, time;
+	sf::Vector2f antenna = type.antenna;
+	if (field.raycast(getPosition(), getPosition() + localToGlobal(antenna), time, obstacles))
+		left = std::min(left, time);
+	antenna.x *= -1.f;
+	if (field.raycast(getPosition(), getPosition() + localToGlobal(antenna), time, obstacles))
+		right = std::min(right, time);
+	avoid(left, right);
+}
+
+void Boid::avoid(float left, float right)
+{
 	if (left < right && left < 1.f)
 	{
 		turn(false, 1 / left);
@@ -206,13 +225,17 @@ void Boid::updateFeeler(const std::vector<std::unique_ptr<Obstacle>>& obstacles)
 	}
 }
 
-void Boid::batchVertices(sf::VertexArray& arr) const
+void Boid::update(sf::Time dt, const BoidArchetype& type)
+{
+	Entity::update(dt, type.acceleration, type.rotate_speed);
+}
+
+void Boid::writeVertices(sf::Vertex* out, const BoidArchetype& type) const
 {
 	sf::Transform trans = getTransform();
-	for (int i = 0; i < 3; i++)
+	for (int i = 0; i < BoidArchetype::VERTEX_COUNT; i++)
 	{
-		sf::Vertex ver = m_body[i];
-		ver.position = trans.transformPoint(ver.position);
-		arr.append(ver);
+		out[i] = type.mesh[i];
+		out[i].position = trans.transformPoint(type.mesh[i].position);
 	}
-}
\ No newline at end of file
+}
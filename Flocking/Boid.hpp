@@ -1,15 +1,24 @@
 #ifndef AI_FLOCK_BOID
 #define AI_FLOCK_BOID
 
+#include <cstdint>
 #include <vector>
 
 #include <SFML/Graphics.hpp>
 
-#include "Obstacle.hpp"
+#include "ObstacleTree.hpp"
+#include "DistanceField.hpp"
+#include "Grid.hpp"
+#include "BoidStore.hpp"
+#include "BoidArchetype.hpp"
+#include "Heading.hpp"
 
 const float DRAG_CONST = 0.05f;
 
-class Entity : public sf::Transformable
+// Position and heading of a moving unit. The rotation is kept as a unit vector,
+// degrees are never needed on the hot path. Engine settings are passed to update,
+// so they can be shared between units.
+class Entity
 {
 public:
 	enum State
@@ -20,7 +29,18 @@ public:
 		THRUST = 1 << 2
 	};
 public:
-	Entity(float acceleration = 1000, float rotate_speed = 200);
+	Entity();
+
+	const sf::Vector2f& getPosition() const;
+
+	void setPosition(sf::Vector2f position);
+
+	const Utilise::Heading& getHeading() const;
+
+	void setHeading(const Utilise::Heading& heading);
+
+	// Built from the heading, for rendering
+	sf::Transform getTransform() const;
 	
 	sf::Vector2f globalToLocal(sf::Vector2f point) const;
 
@@ -28,26 +48,32 @@ public:
 
 	sf::Vector2f getVelocity() const;
 
-	void update(sf::Time dt);
+	float getSpeed() const;
+
+	void setSpeed(float speed);
+
+	// Combination of State flags
+	int getState() const;
+
+	void update(sf::Time dt, float acceleration, float rotate_speed);
 protected:
-	int m_state;
+	std::uint8_t m_state;
 	float thrust_ratio;
 	float rotate_ratio_left;
 	float rotate_ratio_right;
 private:
-	// Fixed variables
-	float m_acceleration;
-	float m_rotate_speed;
-	// Changing variables
 	float m_speed;
+	sf::Vector2f m_position;
+	Utilise::Heading m_heading;
 };
 
+// Only the state that changes every tick, the rest lives in its BoidArchetype
 class Boid : public Entity
 {
 public:
-	Boid(float acceleration = 1000, float rotate_speed = 200,
-		float radius = 50, float angle = 90,
-		float feeler_length = 100, float feeler_angle = 10);
+	explicit Boid(std::uint16_t archetype = 0);
+
+	std::uint16_t getArchetype() const;
 
 	void setThruster(bool enable, float ratio);
 
@@ -55,17 +81,35 @@ public:
 	
 	void turnOff();
 
-	void updateData(const std::vector<Boid*>& boids);
+	// neighbours holds every candidate around the boid, so steering is evaluated once per tick.
+	// Returns the number of visible neighbours.
+	int updateData(const BoidStore& store, int self, Grid::Range neighbours, const BoidArchetype& type);
+
+	// Applies the neighbour steering of the last updateData again, in place of a new one
+	void reuseSteering();
+
+	void updateFeeler(const ObstacleTree& obstacles, const BoidArchetype& type);
 
-	void updateFeeler(const std::vector<std::unique_ptr<Obstacle>>& obstacles);
+	// Same feelers traced through a baked field. Boids further than a feeler
+	// from every obstacle need a single read, boids touching one head out along the gradient.
+	// Traces that run out of steps finish against obstacles.
+	void updateFeeler(const DistanceField& field, const ObstacleTree& obstacles, const BoidArchetype& type);
+
+	void update(sf::Time dt, const BoidArchetype& type);
+
+	// Writes BoidArchetype::VERTEX_COUNT transformed vertices to out
+	void writeVertices(sf::Vertex* out, const BoidArchetype& type) const;
+private:
+	void steer(const NeighbourSums& sums);
 
-	void batchVertices(sf::VertexArray& arr) const;
+	// Turns away from the closer feeler hit, left and right are fractions of the feeler length
+	void avoid(float left, float right);
 private:
-	float m_view_radius;
-	float m_view_angle; // varies from 0 to 180 at max
-	float m_feeler_length;
-	float m_feeler_angle;
-	sf::VertexArray m_body;
+	std::uint16_t m_archetype;
+	// Neighbour steering cached by updateData
+	std::uint8_t m_steer_state;
+	float m_steer_left;
+	float m_steer_right;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "BoidArchetype.hpp"
+#include "Utilise.hpp"
+
+#include <cmath>
+
+BoidArchetype::BoidArchetype(float acceleration, float rotate_speed,
+	float radius, float angle, float feeler_length, float feeler_angle, sf::Color color)
+	: acceleration(acceleration)
+	, rotate_speed(rotate_speed)
+	, antenna(
+		feeler_length * std::sin(Utilise::toRadian(feeler_angle)),
+		feeler_length * std::cos(Utilise::toRadian(feeler_angle)))
+	, antenna_length(feeler_length)
+{
+	cone.radius = radius;
+	cone.wide = angle > 90;
+	cone.side_limit = radius * std::sin(Utilise::toRadian(angle));
+	cone.back_limit = radius * std::cos(Utilise::toRadian(180 - angle));
+
+	mesh[0] = sf::Vertex(sf::Vector2f(0, 5), color);
+	mesh[1] = sf::Vertex(sf::Vector2f(-2.5f, -2), color);
+	mesh[2] = sf::Vertex(sf::Vector2f(2.5f, -2), color);
+}
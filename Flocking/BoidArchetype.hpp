@@ -0,0 +1,30 @@
+#ifndef AI_FLOCK_BOID_ARCHETYPE
+#define AI_FLOCK_BOID_ARCHETYPE
+
+#include <SFML/Graphics.hpp>
+
+#include "BoidStore.hpp"
+
+// Settings shared by every boid of one species, stored once in the flock.
+// Boids only keep the index of theirs.
+struct BoidArchetype
+{
+	static const int VERTEX_COUNT = 3;
+
+	BoidArchetype(float acceleration = 1000, float rotate_speed = 200,
+		float radius = 50, float angle = 90,
+		float feeler_length = 100, float feeler_angle = 10,
+		sf::Color color = sf::Color::White);
+
+	float acceleration;
+	float rotate_speed;
+	// Built from the view radius and angle (0 to 180 at max)
+	ViewCone cone;
+	// Left feeler in local space, the right one is its mirror
+	sf::Vector2f antenna;
+	float antenna_length;
+	// Body in local space
+	sf::Vertex mesh[VERTEX_COUNT];
+};
+
+#endif
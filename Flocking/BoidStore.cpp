@@ -0,0 +1,333 @@
+#include "BoidStore.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Shortest offset along one axis of a periodic world, d is in (-size, size)
+	float nearestImage(float d, float size)
+	{
+		if (d > 0.5f * size)
+			return d - size;
+		if (d < -0.5f * size)
+			return d + size;
+		return d;
+	}
+
+	bool inCone(float lx, float ly, const ViewCone& cone)
+	{
+		return cone.wide
+			? ly >= 0 || std::abs(ly) <= cone.back_limit
+			: ly >= 0 && std::abs(lx) <= cone.side_limit;
+	}
+
+#if defined(AI_SIMD_AVX2)
+	__m256 nearestImage(__m256 d, __m256 size, __m256 half)
+	{
+		d = _mm256_sub_ps(d, _mm256_and_ps(_mm256_cmp_ps(d, half, _CMP_GT_OQ), size));
+		return _mm256_add_ps(d, _mm256_and_ps(_mm256_cmp_ps(d, _mm256_sub_ps(_mm256_setzero_ps(), half), _CMP_LT_OQ), size));
+	}
+
+	float horizontalSum(__m256 v)
+	{
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+	}
+#elif defined(AI_SIMD_SSE2)
+	__m128 nearestImage(__m128 d, __m128 size, __m128 half)
+	{
+		d = _mm_sub_ps(d, _mm_and_ps(_mm_cmpgt_ps(d, half), size));
+		return _mm_add_ps(d, _mm_and_ps(_mm_cmplt_ps(d, _mm_sub_ps(_mm_setzero_ps(), half)), size));
+	}
+
+	float horizontalSum(__m128 v)
+	{
+		__m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+		return _mm_cvtss_f32(sum);
+	}
+
+	__m128 gather(const float* base, const int* id)
+	{
+		return _mm_setr_ps(base[id[0]], base[id[1]], base[id[2]], base[id[3]]);
+	}
+#endif
+}
+
+void NearestNeighbours::reset(int k)
+{
+	count = 0;
+	limit = std::min(std::max(k, 1), MAX_COUNT);
+}
+
+void NearestNeighbours::offer(int id, float distance_squared)
+{
+	int i;
+	if (count < limit)
+	{
+		// Sift up from the new leaf
+		i = count++;
+		while (i > 0 && distances[(i - 1) / 2] < distance_squared)
+		{
+			ids[i] = ids[(i - 1) / 2];
+			distances[i] = distances[(i - 1) / 2];
+			i = (i - 1) / 2;
+		}
+	}
+	else
+	{
+		if (distance_squared >= distances[0])
+			return;
+		// Sift down from the root, which is dropped
+		i = 0;
+		for (;;)
+		{
+			int child = 2 * i + 1;
+			if (child >= count)
+				break;
+			if (child + 1 < count && distances[child + 1] > distances[child])
+				child++;
+			if (distances[child] <= distance_squared)
+				break;
+			ids[i] = ids[child];
+			distances[i] = distances[child];
+			i = child;
+		}
+	}
+	ids[i] = id;
+	distances[i] = distance_squared;
+}
+
+bool NearestNeighbours::full() const
+{
+	return count == limit;
+}
+
+float NearestNeighbours::farthest() const
+{
+	return distances[0];
+}
+
+BoidStore::BoidStore()
+	: m_world_size(1000.f, 1000.f)
+{ }
+
+void BoidStore::resize(int count)
+{
+	m_x.resize(count);
+	m_y.resize(count);
+	m_cos.resize(count);
+	m_sin.resize(count);
+	m_speed.resize(count);
+}
+
+void BoidStore::setWorldSize(sf::Vector2f size)
+{
+	m_world_size = size;
+}
+
+int BoidStore::size() const
+{
+	return static_cast<int>(m_x.size());
+}
+
+void BoidStore::write(int id, sf::Vector2f position, sf::Vector2f direction, float speed)
+{
+	m_x[id] = position.x;
+	m_y[id] = position.y;
+	m_cos[id] = direction.x;
+	m_sin[id] = direction.y;
+	m_speed[id] = speed;
+}
+
+NeighbourSums BoidStore::accumulate(int self, const int* first, const int* last, const ViewCone& cone) const
+{
+	NeighbourSums sums;
+#if defined(AI_SIMD_AVX2)
+	if (last - first >= 8)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 sign = _mm256_set1_ps(-0.f);
+		const __m256 sx = _mm256_set1_ps(m_x[self]), sy = _mm256_set1_ps(m_y[self]);
+		const __m256 sc = _mm256_set1_ps(m_cos[self]), ss = _mm256_set1_ps(m_sin[self]);
+		const __m256 radius = _mm256_set1_ps(cone.radius);
+		const __m256 limit = _mm256_set1_ps(cone.wide ? cone.back_limit : cone.side_limit);
+		const __m256 close_ratio = _mm256_set1_ps(2.5f);
+		const __m256 push = _mm256_set1_ps(0.2f * cone.radius);
+		const __m256i self_id = _mm256_set1_epi32(self);
+		const __m256 world_x = _mm256_set1_ps(m_world_size.x), half_x = _mm256_set1_ps(0.5f * m_world_size.x);
+		const __m256 world_y = _mm256_set1_ps(m_world_size.y), half_y = _mm256_set1_ps(0.5f * m_world_size.y);
+		__m256 count = zero, left = zero, right = zero;
+		__m256 vel_x = zero, vel_y = zero, off_x = zero, off_y = zero;
+		for (; last - first >= 8; first += 8)
+		{
+			__m256i id = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+			__m256 px = _mm256_i32gather_ps(m_x.data(), id, 4);
+			__m256 py = _mm256_i32gather_ps(m_y.data(), id, 4);
+			__m256 dx = nearestImage(_mm256_sub_ps(px, sx), world_x, half_x);
+			__m256 dy = nearestImage(_mm256_sub_ps(py, sy), world_y, half_y);
+			__m256 lx = _mm256_add_ps(_mm256_mul_ps(dx, sc), _mm256_mul_ps(dy, ss));
+			__m256 ly = _mm256_sub_ps(_mm256_mul_ps(dy, sc), _mm256_mul_ps(dx, ss));
+			__m256 lth = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+
+			__m256 mask = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(id, self_id)),
+				_mm256_cmp_ps(lth, radius, _CMP_LE_OQ));
+			__m256 ahead = _mm256_cmp_ps(ly, zero, _CMP_GE_OQ);
+			if (cone.wide)
+				mask = _mm256_and_ps(mask, _mm256_or_ps(ahead,
+					_mm256_cmp_ps(_mm256_andnot_ps(sign, ly), limit, _CMP_LE_OQ)));
+			else
+				mask = _mm256_and_ps(mask, _mm256_and_ps(ahead,
+					_mm256_cmp_ps(_mm256_andnot_ps(sign, lx), limit, _CMP_LE_OQ)));
+			if (_mm256_movemask_ps(mask) == 0)
+				continue;
+			count = _mm256_add_ps(count, _mm256_and_ps(mask, one));
+
+			__m256 scaled = _mm256_mul_ps(close_ratio, lth);
+			__m256 close = _mm256_and_ps(mask, _mm256_cmp_ps(scaled, radius, _CMP_LE_OQ));
+			__m256 weight = _mm256_and_ps(close, _mm256_div_ps(push, scaled));
+			__m256 on_right = _mm256_cmp_ps(lx, zero, _CMP_GT_OQ);
+			right = _mm256_add_ps(right, _mm256_and_ps(on_right, weight));
+			left = _mm256_add_ps(left, _mm256_andnot_ps(on_right, weight));
+
+			__m256 speed = _mm256_i32gather_ps(m_speed.data(), id, 4);
+			__m256 cs = _mm256_i32gather_ps(m_cos.data(), id, 4);
+			__m256 sn = _mm256_i32gather_ps(m_sin.data(), id, 4);
+			vel_x = _mm256_sub_ps(vel_x, _mm256_and_ps(mask, _mm256_mul_ps(speed, sn)));
+			vel_y = _mm256_add_ps(vel_y, _mm256_and_ps(mask, _mm256_mul_ps(speed, cs)));
+			off_x = _mm256_add_ps(off_x, _mm256_and_ps(mask, dx));
+			off_y = _mm256_add_ps(off_y, _mm256_and_ps(mask, dy));
+		}
+		sums.count = static_cast<int>(horizontalSum(count));
+		sums.separation_left = horizontalSum(left);
+		sums.separation_right = horizontalSum(right);
+		sums.velocity = sf::Vector2f(horizontalSum(vel_x), horizontalSum(vel_y));
+		sums.offset = sf::Vector2f(horizontalSum(off_x), horizontalSum(off_y));
+	}
+#elif defined(AI_SIMD_SSE2)
+	if (last - first >= 4)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 sign = _mm_set1_ps(-0.f);
+		const __m128 sx = _mm_set1_ps(m_x[self]), sy = _mm_set1_ps(m_y[self]);
+		const __m128 sc = _mm_set1_ps(m_cos[self]), ss = _mm_set1_ps(m_sin[self]);
+		const __m128 radius = _mm_set1_ps(cone.radius);
+		const __m128 limit = _mm_set1_ps(cone.wide ? cone.back_limit : cone.side_limit);
+		const __m128 close_ratio = _mm_set1_ps(2.5f);
+		const __m128 push = _mm_set1_ps(0.2f * cone.radius);
+		const __m128i self_id = _mm_set1_epi32(self);
+		const __m128 world_x = _mm_set1_ps(m_world_size.x), half_x = _mm_set1_ps(0.5f * m_world_size.x);
+		const __m128 world_y = _mm_set1_ps(m_world_size.y), half_y = _mm_set1_ps(0.5f * m_world_size.y);
+		__m128 count = zero, left = zero, right = zero;
+		__m128 vel_x = zero, vel_y = zero, off_x = zero, off_y = zero;
+		for (; last - first >= 4; first += 4)
+		{
+			__m128i id = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			__m128 px = gather(m_x.data(), first);
+			__m128 py = gather(m_y.data(), first);
+			__m128 dx = nearestImage(_mm_sub_ps(px, sx), world_x, half_x);
+			__m128 dy = nearestImage(_mm_sub_ps(py, sy), world_y, half_y);
+			__m128 lx = _mm_add_ps(_mm_mul_ps(dx, sc), _mm_mul_ps(dy, ss));
+			__m128 ly = _mm_sub_ps(_mm_mul_ps(dy, sc), _mm_mul_ps(dx, ss));
+			__m128 lth = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+			__m128 mask = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(id, self_id)),
+				_mm_cmple_ps(lth, radius));
+			__m128 ahead = _mm_cmpge_ps(ly, zero);
+			if (cone.wide)
+				mask = _mm_and_ps(mask, _mm_or_ps(ahead, _mm_cmple_ps(_mm_andnot_ps(sign, ly), limit)));
+			else
+				mask = _mm_and_ps(mask, _mm_and_ps(ahead, _mm_cmple_ps(_mm_andnot_ps(sign, lx), limit)));
+			if (_mm_movemask_ps(mask) == 0)
+				continue;
+			count = _mm_add_ps(count, _mm_and_ps(mask, one));
+
+			__m128 scaled = _mm_mul_ps(close_ratio, lth);
+			__m128 close = _mm_and_ps(mask, _mm_cmple_ps(scaled, radius));
+			__m128 weight = _mm_and_ps(close, _mm_div_ps(push, scaled));
+			__m128 on_right = _mm_cmpgt_ps(lx, zero);
+			right = _mm_add_ps(right, _mm_and_ps(on_right, weight));
+			left = _mm_add_ps(left, _mm_andnot_ps(on_right, weight));
+
+			__m128 speed = gather(m_speed.data(), first);
+			__m128 cs = gather(m_cos.data(), first);
+			__m128 sn = gather(m_sin.data(), first);
+			vel_x = _mm_sub_ps(vel_x, _mm_and_ps(mask, _mm_mul_ps(speed, sn)));
+			vel_y = _mm_add_ps(vel_y, _mm_and_ps(mask, _mm_mul_ps(speed, cs)));
+			off_x = _mm_add_ps(off_x, _mm_and_ps(mask, dx));
+			off_y = _mm_add_ps(off_y, _mm_and_ps(mask, dy));
+		}
+		sums.count = static_cast<int>(horizontalSum(count));
+		sums.separation_left = horizontalSum(left);
+		sums.separation_right = horizontalSum(right);
+		sums.velocity = sf::Vector2f(horizontalSum(vel_x), horizontalSum(vel_y));
+		sums.offset = sf::Vector2f(horizontalSum(off_x), horizontalSum(off_y));
+	}
+#endif
+	accumulateScalar(self, first, last, cone, sums);
+	return sums;
+}
+
+void BoidStore::selectNearest(int self, const int* first, const int* last, const ViewCone& cone, NearestNeighbours& nearest) const
+{
+	float sx = m_x[self], sy = m_y[self], sc = m_cos[self], ss = m_sin[self];
+	float radius_squared = cone.radius * cone.radius;
+	for (; first != last; first++)
+	{
+		int id = *first;
+		if (id == self)
+			continue;
+		float dx = nearestImage(m_x[id] - sx, m_world_size.x);
+		float dy = nearestImage(m_y[id] - sy, m_world_size.y);
+		float distance_squared = dx * dx + dy * dy;
+		if (distance_squared > radius_squared || (nearest.full() && distance_squared >= nearest.farthest()))
+			continue;
+		if (inCone(dx * sc + dy * ss, dy * sc - dx * ss, cone))
+			nearest.offer(id, distance_squared);
+	}
+}
+
+const float* BoidStore::positionX() const
+{
+	return m_x.data();
+}
+
+const float* BoidStore::positionY() const
+{
+	return m_y.data();
+}
+
+void BoidStore::accumulateScalar(int self, const int* first, const int* last, const ViewCone& cone, NeighbourSums& sums) const
+{
+	float sx = m_x[self], sy = m_y[self], sc = m_cos[self], ss = m_sin[self];
+	for (; first != last; first++)
+	{
+		int id = *first;
+		if (id == self)
+			continue;
+		float dx = nearestImage(m_x[id] - sx, m_world_size.x);
+		float dy = nearestImage(m_y[id] - sy, m_world_size.y);
+		float lx = dx * sc + dy * ss, ly = dy * sc - dx * ss;
+		float lth = std::sqrt(dx * dx + dy * dy);
+		if (lth > cone.radius)
+			continue;
+		if (!inCone(lx, ly, cone))
+			continue;
+		sums.count++;
+		if (2.5f * lth <= cone.radius)
+		{
+			if (lx > 0)
+				sums.separation_right += 0.2f * cone.radius / (2.5f * lth);
+			else
+				sums.separation_left += 0.2f * cone.radius / (2.5f * lth);
+		}
+		sums.velocity += m_speed[id] * sf::Vector2f(-m_sin[id], m_cos[id]);
+		sums.offset += sf::Vector2f(dx, dy);
+	}
+}
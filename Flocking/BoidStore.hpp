@@ -0,0 +1,94 @@
+#ifndef AI_FLOCK_BOID_STORE
+#define AI_FLOCK_BOID_STORE
+
+#include <SFML/Graphics.hpp>
+
+#include "AlignedArray.hpp"
+
+// Field of view of a boid, expressed in its local frame
+// (x to the side, y forward)
+struct ViewCone
+{
+	float radius;
+	// Used when the view angle is at most 90: max |x| of a visible unit in front
+	float side_limit;
+	// Used when the view angle is over 90: max |y| of a visible unit behind
+	float back_limit;
+	bool wide;
+};
+
+// Sums over the visible units of one neighbour query
+struct NeighbourSums
+{
+	int count = 0;
+	float separation_left = 0.f;
+	float separation_right = 0.f;
+	sf::Vector2f velocity;
+	// Sum of the shortest offsets from self, which may cross the edges of the world
+	sf::Vector2f offset;
+};
+
+// Closest visible units of one topological query, a max-heap on squared distance
+// so the farthest one is replaced first
+struct NearestNeighbours
+{
+	static const int MAX_COUNT = 32;
+
+	// Empties the set and keeps at most k units, clamped to [1, MAX_COUNT]
+	void reset(int k);
+
+	// Keeps id if there is room or it is closer than the farthest one kept
+	void offer(int id, float distance_squared);
+
+	bool full() const;
+
+	// Squared distance of the farthest unit kept
+	float farthest() const;
+
+	int count;
+	int limit;
+	int ids[MAX_COUNT];
+	float distances[MAX_COUNT];
+};
+
+// Structure-of-arrays snapshot of the flock, written once per tick.
+// Neighbour rules read it instead of chasing Boid pointers.
+class BoidStore
+{
+public:
+	BoidStore();
+
+	void resize(int count);
+
+	// Offsets between units are taken across the edges of a periodic world of this size
+	void setWorldSize(sf::Vector2f size);
+
+	int size() const;
+
+	// direction is the unit vector of the heading, see Utilise::Heading
+	void write(int id, sf::Vector2f position, sf::Vector2f direction, float speed);
+
+	// Accumulates separation, alignment and cohesion terms of the candidates
+	// that self can see. Uses AVX2 or SSE2 when available.
+	NeighbourSums accumulate(int self, const int* first, const int* last, const ViewCone& cone) const;
+
+	// Offers the candidates that self can see to nearest. Candidates no closer
+	// than the farthest one kept are rejected before the view test.
+	void selectNearest(int self, const int* first, const int* last, const ViewCone& cone, NearestNeighbours& nearest) const;
+
+	const float* positionX() const;
+
+	const float* positionY() const;
+private:
+	void accumulateScalar(int self, const int* first, const int* last, const ViewCone& cone, NeighbourSums& sums) const;
+private:
+	AlignedArray<float> m_x;
+	AlignedArray<float> m_y;
+	// Heading direction. The local x axis is (cos, sin) and forward is (-sin, cos)
+	AlignedArray<float> m_cos;
+	AlignedArray<float> m_sin;
+	AlignedArray<float> m_speed;
+	sf::Vector2f m_world_size;
+};
+
+#endif
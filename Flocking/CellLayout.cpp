@@ -0,0 +1,117 @@
+#include "CellLayout.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	int cellsAlong(float world, float cell_size)
+	{
+		return std::max(1, static_cast<int>(std::floor(world / cell_size)));
+	}
+
+	std::vector<int> wrapTable(int dimension, int reach)
+	{
+		std::vector<int> table(dimension + 2 * reach);
+		for (int i = 0; i < dimension + 2 * reach; i++)
+			table[i] = ((i - reach) % dimension + dimension) % dimension;
+		return table;
+	}
+
+	unsigned int hashMask(int buckets)
+	{
+		if (buckets <= 0)
+			return 0;
+		unsigned int size = 2;
+		while (size < static_cast<unsigned int>(buckets) && size < (1u << 30))
+			size <<= 1;
+		return size - 1;
+	}
+
+	int wrapCell(int c, int dimension)
+	{
+		if (c >= dimension)
+			c %= dimension;
+		else if (c < 0)
+			c = dimension - 1 - (-c - 1) % dimension;
+		return c;
+	}
+}
+
+CellLayout::CellLayout(float cell_size, sf::Vector2f world_size, int hashed_buckets, int reach)
+	: m_world_size(world_size)
+	, m_dimension(cellsAlong(world_size.x, cell_size), cellsAlong(world_size.y, cell_size))
+	, m_cell_size(world_size.x / m_dimension.x, world_size.y / m_dimension.y)
+	, m_reach(std::min(std::max(reach, 1), MAX_REACH))
+	, m_span(std::min(2 * m_reach + 1, m_dimension.x), std::min(2 * m_reach + 1, m_dimension.y))
+	, m_wrap_x(wrapTable(m_dimension.x, m_reach))
+	, m_wrap_y(wrapTable(m_dimension.y, m_reach))
+	, m_hash_mask(hashMask(hashed_buckets))
+{ }
+
+sf::Vector2i CellLayout::cellOf(sf::Vector2f position) const
+{
+	return sf::Vector2i(
+		wrapCell(static_cast<int>(std::floor(position.x / m_cell_size.x)), m_dimension.x),
+		wrapCell(static_cast<int>(std::floor(position.y / m_cell_size.y)), m_dimension.y));
+}
+
+int CellLayout::cellCount() const
+{
+	if (m_hash_mask != 0)
+		return static_cast<int>(m_hash_mask + 1);
+	return m_dimension.x * m_dimension.y;
+}
+
+bool CellLayout::isHashed() const
+{
+	return m_hash_mask != 0;
+}
+
+const sf::Vector2i& CellLayout::getDimension() const
+{
+	return m_dimension;
+}
+
+int CellLayout::getReach() const
+{
+	return m_reach;
+}
+
+bool CellLayout::hasRings() const
+{
+	return m_hash_mask == 0 && m_dimension.x >= 2 * m_reach + 1 && m_dimension.y >= 2 * m_reach + 1;
+}
+
+float CellLayout::ringClearance(sf::Vector2f position, int ring) const
+{
+	float fx = position.x / m_cell_size.x, fy = position.y / m_cell_size.y;
+	fx -= std::floor(fx);
+	fy -= std::floor(fy);
+	return std::min(
+		std::min(fx + ring, 1.f - fx + ring) * m_cell_size.x,
+		std::min(fy + ring, 1.f - fy + ring) * m_cell_size.y);
+}
+
+sf::Vector2f CellLayout::getCellSize() const
+{
+	return m_cell_size;
+}
+
+sf::Vector2f CellLayout::getWorldSize() const
+{
+	return m_world_size;
+}
+
+sf::Vector2f CellLayout::wrap(sf::Vector2f position) const
+{
+	if (position.x < 0)
+		position.x += m_world_size.x;
+	else if (position.x >= m_world_size.x)
+		position.x -= m_world_size.x;
+	if (position.y < 0)
+		position.y += m_world_size.y;
+	else if (position.y >= m_world_size.y)
+		position.y -= m_world_size.y;
+	return position;
+}
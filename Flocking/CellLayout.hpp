@@ -0,0 +1,143 @@
+#ifndef AI_FLOCK_CELL_LAYOUT
+#define AI_FLOCK_CELL_LAYOUT
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Cells of a periodic (toroidal) world, shared by the spatial indices.
+// Dense layouts number cells row by row, y * width + x. Hashed layouts fold the
+// cells of worlds too large to store into a fixed number of buckets, so memory
+// follows the number of units rather than the area. Units of unrelated cells may
+// then share a bucket, which neighbour rules already reject by distance.
+class CellLayout
+{
+public:
+	static const int MAX_REACH = 2;
+public:
+	// Covers the rectangle [0, world_size.x) x [0, world_size.y), whose opposite edges meet.
+	// Cells are at least cell_size wide and divide the world evenly.
+	// hashed_buckets > 0 selects the hashed layout, rounded up to a power of two.
+	// Neighbour queries visit reach rings of cells around a position, clamped to
+	// [1, MAX_REACH], so they find every unit within reach * cell_size.
+	CellLayout(float cell_size, sf::Vector2f world_size, int hashed_buckets = 0, int reach = 1);
+
+	// position is wrapped into the world first
+	sf::Vector2i cellOf(sf::Vector2f position) const;
+
+	// Id of the cell at wrapped coordinates x, y
+	int idOfCell(int x, int y) const
+	{
+		if (m_hash_mask == 0)
+			return y * m_dimension.x + x;
+		// Mixes both coordinates so neighbouring cells land in unrelated buckets
+		unsigned int h = static_cast<unsigned int>(x) * 73856093u ^ static_cast<unsigned int>(y) * 19349663u;
+		return static_cast<int>((h ^ (h >> 15)) & m_hash_mask);
+	}
+
+	int idOf(sf::Vector2f position) const
+	{
+		sf::Vector2i coord = cellOf(position);
+		return idOfCell(coord.x, coord.y);
+	}
+
+	// Number of ids, buckets for a hashed layout
+	int cellCount() const;
+
+	bool isHashed() const;
+
+	const sf::Vector2i& getDimension() const;
+
+	int getReach() const;
+
+	// Calls func(id) for the block of cells within reach of the cell of position,
+	// wrapping across the edges of the world. Each id is visited once, even when
+	// the grid is narrower than the block or two cells share a bucket.
+	template<typename Func>
+	void forEachNeighbourId(sf::Vector2f position, Func func) const
+	{
+		sf::Vector2i coord = cellOf(position);
+		// Offset by reach for the ghost rings of the wrap tables
+		int first_x = m_dimension.x >= 2 * m_reach + 1 ? coord.x : m_reach;
+		int first_y = m_dimension.y >= 2 * m_reach + 1 ? coord.y : m_reach;
+		if (m_hash_mask == 0)
+		{
+			for (int i = 0; i < m_span.y; i++)
+			{
+				int row = m_wrap_y[first_y + i] * m_dimension.x;
+				for (int j = 0; j < m_span.x; j++)
+					func(row + m_wrap_x[first_x + j]);
+			}
+			return;
+		}
+		int ids[(2 * MAX_REACH + 1) * (2 * MAX_REACH + 1)], count = 0;
+		for (int i = 0; i < m_span.y; i++)
+			for (int j = 0; j < m_span.x; j++)
+			{
+				int id = idOfCell(m_wrap_x[first_x + j], m_wrap_y[first_y + i]);
+				bool seen = false;
+				for (int k = 0; k < count; k++)
+					seen |= ids[k] == id;
+				if (!seen)
+				{
+					ids[count++] = id;
+					func(id);
+				}
+			}
+	}
+
+	// True when the rings around a cell are distinct cells, which forEachRingId needs.
+	// Hashed layouts and grids narrower than 2 * reach + 1 cells have to be scanned as a block.
+	bool hasRings() const;
+
+	// Calls func(id) for the cells exactly ring steps away from the cell of position,
+	// ring in [0, reach]. Ring 0 is the cell itself. Only valid when hasRings().
+	template<typename Func>
+	void forEachRingId(sf::Vector2f position, int ring, Func func) const
+	{
+		sf::Vector2i coord = cellOf(position);
+		// Positions in the wrap tables
+		int x = coord.x + m_reach, y = coord.y + m_reach;
+		for (int i = -ring; i <= ring; i++)
+		{
+			int row = m_wrap_y[y + i] * m_dimension.x;
+			// Whole top and bottom rows, only the ends of the others
+			int step = i == -ring || i == ring ? 1 : 2 * ring;
+			for (int j = -ring; j <= ring; j += step)
+				func(row + m_wrap_x[x + j]);
+		}
+	}
+
+	// Distance from position to the nearest cell further than ring steps from its own
+	float ringClearance(sf::Vector2f position, int ring) const;
+
+	sf::Vector2f getCellSize() const;
+
+	sf::Vector2f getWorldSize() const;
+
+	// Brings position back into [0, world_size)
+	sf::Vector2f wrap(sf::Vector2f position) const;
+private:
+	sf::Vector2f m_world_size;
+	sf::Vector2i m_dimension;
+	sf::Vector2f m_cell_size;
+	int m_reach;
+	// Cells visited per axis by a neighbour query, min(2 * reach + 1, dimension)
+	sf::Vector2i m_span;
+	// Column and row of cell coordinates -reach to dimension + reach - 1, the rings outside the grid map to the opposite edge
+	std::vector<int> m_wrap_x;
+	std::vector<int> m_wrap_y;
+	// Bucket count - 1 for a hashed layout, 0 for a dense one
+	unsigned int m_hash_mask;
+};
+
+// How full the cells of an index are
+struct CellOccupancy
+{
+	// Cells, or buckets, holding at least one unit
+	int occupied;
+	// Units in the fullest cell
+	int largest;
+};
+
+#endif
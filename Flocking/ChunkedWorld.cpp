@@ -0,0 +1,151 @@
+#include "ChunkedWorld.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float SPEED_SCALE = 64.f;
+	const float ANGLE_SCALE = 65536.f / 360.f;
+
+	std::uint16_t quantise(float value, float scale)
+	{
+		return static_cast<std::uint16_t>(std::min(65535.f, std::max(0.f, value * scale + 0.5f)));
+	}
+
+	// Shortest offset along one axis of a periodic world
+	float nearestImage(float d, float size)
+	{
+		d = std::fmod(d, size);
+		if (d > 0.5f * size)
+			return d - size;
+		if (d < -0.5f * size)
+			return d + size;
+		return d;
+	}
+}
+
+ChunkedWorld::ChunkedWorld(float chunk_size, sf::Vector2f world_size)
+	: m_chunk_size(chunk_size)
+	, m_world_size(world_size)
+	, m_dimension(
+		std::max(1, static_cast<int>(std::ceil(world_size.x / chunk_size))),
+		std::max(1, static_cast<int>(std::ceil(world_size.y / chunk_size))))
+	, m_parked(0)
+{ }
+
+sf::Vector2i ChunkedWorld::chunkOf(sf::Vector2f position) const
+{
+	int x = static_cast<int>(std::floor(position.x / m_chunk_size));
+	int y = static_cast<int>(std::floor(position.y / m_chunk_size));
+	return sf::Vector2i(
+		std::min(std::max(x, 0), m_dimension.x - 1),
+		std::min(std::max(y, 0), m_dimension.y - 1));
+}
+
+bool ChunkedWorld::overlaps(sf::Vector2i chunk, sf::Vector2f centre, float radius) const
+{
+	sf::Vector2f min(chunk.x * m_chunk_size, chunk.y * m_chunk_size);
+	sf::Vector2f size(
+		std::min(m_chunk_size, m_world_size.x - min.x),
+		std::min(m_chunk_size, m_world_size.y - min.y));
+	// Distance from centre to the chunk, taken from the nearest image of the chunk
+	float dx = std::abs(nearestImage(min.x + 0.5f * size.x - centre.x, m_world_size.x)) - 0.5f * size.x;
+	float dy = std::abs(nearestImage(min.y + 0.5f * size.y - centre.y, m_world_size.y)) - 0.5f * size.y;
+	dx = std::max(dx, 0.f);
+	dy = std::max(dy, 0.f);
+	return dx * dx + dy * dy <= radius * radius;
+}
+
+void ChunkedWorld::park(const Boid& boid, SlotMap::Handle id)
+{
+	sf::Vector2i chunk = chunkOf(boid.getPosition());
+	// Chunks are at most 65536 / 64 = 1024 units wide at this precision, larger ones lose detail
+	float scale = std::min(64.f, 65535.f / m_chunk_size);
+	float angle = boid.getHeading().toDegree();
+	if (angle < 0.f)
+		angle += 360.f;
+
+	ColdBoid cold;
+	cold.id = id;
+	cold.x = quantise(boid.getPosition().x - chunk.x * m_chunk_size, scale);
+	cold.y = quantise(boid.getPosition().y - chunk.y * m_chunk_size, scale);
+	cold.angle = static_cast<std::uint16_t>(static_cast<int>(angle * ANGLE_SCALE + 0.5f) & 0xffff);
+	cold.speed = quantise(boid.getSpeed(), SPEED_SCALE);
+	cold.archetype = boid.getArchetype();
+	m_chunks[key(chunk)].boids.push_back(cold);
+	m_parked++;
+}
+
+void ChunkedWorld::unpark(sf::Vector2f centre, float radius, std::vector<ParkedBoid>& out)
+{
+	std::vector<std::uint64_t> keys;
+	// Chunk coordinates under the bounding box of the region, unwrapped. Past an edge of
+	// the world the short last chunk shifts them by up to one, hence the extra ring.
+	int first_x = static_cast<int>(std::floor((centre.x - radius) / m_chunk_size)) - 1;
+	int first_y = static_cast<int>(std::floor((centre.y - radius) / m_chunk_size)) - 1;
+	int span_x = static_cast<int>(std::floor((centre.x + radius) / m_chunk_size)) - first_x + 2;
+	int span_y = static_cast<int>(std::floor((centre.y + radius) / m_chunk_size)) - first_y + 2;
+	if (span_x < m_dimension.x && span_y < m_dimension.y
+		&& static_cast<long long>(span_x) * span_y < static_cast<long long>(m_chunks.size()))
+	{
+		// Small region, look its chunks up instead of scanning every parked chunk
+		for (int y = first_y; y < first_y + span_y; y++)
+			for (int x = first_x; x < first_x + span_x; x++)
+			{
+				sf::Vector2i chunk((x % m_dimension.x + m_dimension.x) % m_dimension.x,
+					(y % m_dimension.y + m_dimension.y) % m_dimension.y);
+				if (m_chunks.count(key(chunk)) && overlaps(chunk, centre, radius))
+					keys.push_back(key(chunk));
+			}
+	}
+	else
+	{
+		for (auto& i : m_chunks)
+		{
+			sf::Vector2i chunk(static_cast<int>(i.first >> 32), static_cast<int>(i.first & 0xffffffffu));
+			if (overlaps(chunk, centre, radius))
+				keys.push_back(i.first);
+		}
+	}
+	std::sort(keys.begin(), keys.end());
+
+	float scale = std::min(64.f, 65535.f / m_chunk_size);
+	for (std::uint64_t k : keys)
+	{
+		auto it = m_chunks.find(k);
+		sf::Vector2f corner(static_cast<int>(k >> 32) * m_chunk_size, static_cast<int>(k & 0xffffffffu) * m_chunk_size);
+		for (const ColdBoid& cold : it->second.boids)
+		{
+			ParkedBoid boid;
+			boid.id = cold.id;
+			boid.position = corner + sf::Vector2f(cold.x / scale, cold.y / scale);
+			boid.heading = Utilise::Heading(cold.angle / ANGLE_SCALE);
+			boid.speed = cold.speed / SPEED_SCALE;
+			boid.archetype = cold.archetype;
+			out.push_back(boid);
+		}
+		m_parked -= static_cast<int>(it->second.boids.size());
+		m_chunks.erase(it);
+	}
+}
+
+int ChunkedWorld::getChunkCount() const
+{
+	return static_cast<int>(m_chunks.size());
+}
+
+int ChunkedWorld::getParkedCount() const
+{
+	return m_parked;
+}
+
+float ChunkedWorld::getChunkSize() const
+{
+	return m_chunk_size;
+}
+
+std::uint64_t ChunkedWorld::key(sf::Vector2i chunk)
+{
+	return static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunk.x)) << 32 | static_cast<std::uint32_t>(chunk.y);
+}
@@ -0,0 +1,78 @@
+#ifndef AI_FLOCK_CHUNKED_WORLD
+#define AI_FLOCK_CHUNKED_WORLD
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Boid.hpp"
+#include "SlotMap.hpp"
+
+// Splits a periodic world into square chunks and keeps the boids of inactive
+// chunks parked in a compact cold form. Only chunks holding parked boids are
+// allocated, so memory follows the occupied area rather than the world size.
+class ChunkedWorld
+{
+public:
+	// Parked boid, quantised relative to the corner of its chunk. 16 bytes.
+	struct ColdBoid
+	{
+		// Handle the boid gets back when woken up
+		SlotMap::Handle id;
+		std::uint16_t x;
+		std::uint16_t y;
+		// One turn is 65536
+		std::uint16_t angle;
+		// 1/64 units per second
+		std::uint16_t speed;
+		std::uint16_t archetype;
+	};
+
+	// ColdBoid decoded back to world units
+	struct ParkedBoid
+	{
+		SlotMap::Handle id;
+		sf::Vector2f position;
+		Utilise::Heading heading;
+		float speed;
+		std::uint16_t archetype;
+	};
+public:
+	// The last row and column of chunks are cut short when chunk_size does not divide the world
+	ChunkedWorld(float chunk_size, sf::Vector2f world_size);
+
+	sf::Vector2i chunkOf(sf::Vector2f position) const;
+
+	// True if part of the chunk lies within radius of centre, across the edges of the world
+	bool overlaps(sf::Vector2i chunk, sf::Vector2f centre, float radius) const;
+
+	void park(const Boid& boid, SlotMap::Handle id);
+
+	// Appends the boids of every parked chunk that overlaps the region to out and frees
+	// those chunks. Chunks are visited in key order so the result does not depend on
+	// the hash table.
+	void unpark(sf::Vector2f centre, float radius, std::vector<ParkedBoid>& out);
+
+	int getChunkCount() const;
+
+	int getParkedCount() const;
+
+	float getChunkSize() const;
+private:
+	static std::uint64_t key(sf::Vector2i chunk);
+private:
+	struct Chunk
+	{
+		std::vector<ColdBoid> boids;
+	};
+private:
+	float m_chunk_size;
+	sf::Vector2f m_world_size;
+	sf::Vector2i m_dimension;
+	std::unordered_map<std::uint64_t, Chunk> m_chunks;
+	int m_parked;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "DistanceField.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char MAGIC[4] = { 'A', 'I', 'S', 'D' };
+	const std::uint32_t VERSION = 2;
+	const int MAX_TRACE_STEPS = 32;
+	// Side of the square blocks of texels build gathers obstacles for
+	const int TILE_SIZE = 16;
+
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t key;
+		std::int32_t width;
+		std::int32_t height;
+		float origin_x;
+		float origin_y;
+		float texel_size;
+	};
+
+	// Field by field, so no padding reaches the file
+	template<typename T>
+	void write(std::ostream& file, const T& value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool read(std::istream& file, T& value)
+	{
+		return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	// FNV-1a over the bytes of value
+	template<typename T>
+	void hash(std::uint64_t& key, const T& value)
+	{
+		unsigned char bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+		for (unsigned char i : bytes)
+		{
+			key ^= i;
+			key *= 1099511628211ull;
+		}
+	}
+
+	void hash(std::uint64_t& key, sf::FloatRect rect)
+	{
+		hash(key, rect.left);
+		hash(key, rect.top);
+		hash(key, rect.width);
+		hash(key, rect.height);
+	}
+}
+
+DistanceField::DistanceField()
+	: m_texel_size(1.f)
+	, m_key(0)
+{ }
+
+void DistanceField::build(const ObstacleSet& obstacles, const ObstacleTree& tree, sf::FloatRect area, float texel_size,
+	WorkerPool& pool)
+{
+	m_origin = sf::Vector2f(area.left, area.top);
+	m_texel_size = texel_size;
+	m_dimension = sf::Vector2i(
+		std::max(2, static_cast<int>(std::ceil(area.width / texel_size)) + 1),
+		std::max(2, static_cast<int>(std::ceil(area.height / texel_size)) + 1));
+	m_values.resize(m_dimension.x * m_dimension.y);
+	m_key = makeKey(obstacles, area, texel_size);
+	// Keeps the field finite, and so filterable, when there is no obstacle
+	float far = std::sqrt(area.width * area.width + area.height * area.height);
+	int tiles_x = (m_dimension.x + TILE_SIZE - 1) / TILE_SIZE;
+	int tiles_y = (m_dimension.y + TILE_SIZE - 1) / TILE_SIZE;
+	pool.parallelFor(tiles_x * tiles_y, 1, [&](int first, int last, int)
+		{
+			ObstacleSet nearby;
+			for (int tile = first; tile < last; tile++)
+			{
+				int x0 = tile % tiles_x * TILE_SIZE, y0 = tile / tiles_x * TILE_SIZE;
+				int x1 = std::min(x0 + TILE_SIZE, m_dimension.x), y1 = std::min(y0 + TILE_SIZE, m_dimension.y);
+				sf::Vector2f min = m_origin + sf::Vector2f(x0 * texel_size, y0 * texel_size);
+				sf::Vector2f max = m_origin + sf::Vector2f((x1 - 1) * texel_size, (y1 - 1) * texel_size);
+				// No texel of the tile is further from an obstacle than the centre plus the
+				// half diagonal, so its nearest shape has bounds within that reach of the tile.
+				// The extra texel covers the rounding of the tree's copy of the shapes.
+				sf::Vector2f half = (max - min) / 2.f;
+				float reach = obstacles.distance(min + half) + std::sqrt(half.x * half.x + half.y * half.y) + texel_size;
+				reach = std::max(reach, 0.f);
+				nearby.clear();
+				tree.gather(min - sf::Vector2f(reach, reach), max + sf::Vector2f(reach, reach), nearby);
+				for (int y = y0; y < y1; y++)
+				{
+					float* row = m_values.data() + y * m_dimension.x;
+					for (int x = x0; x < x1; x++)
+						row[x] = std::min(far, nearby.distance(m_origin + sf::Vector2f(x * texel_size, y * texel_size)));
+				}
+			}
+		});
+}
+
+bool DistanceField::buildCached(const ObstacleSet& obstacles, const ObstacleTree& tree, sf::FloatRect area,
+	float texel_size, WorkerPool& pool, const std::string& cache_path)
+{
+	if (!cache_path.empty() && load(cache_path, makeKey(obstacles, area, texel_size)))
+		return true;
+	build(obstacles, tree, area, texel_size, pool);
+	if (!cache_path.empty())
+		save(cache_path);
+	return false;
+}
+
+bool DistanceField::empty() const
+{
+	return m_values.empty();
+}
+
+float DistanceField::distance(sf::Vector2f position) const
+{
+	int id;
+	float fx, fy;
+	locate(position, id, fx, fy);
+	const float* v = m_values.data() + id;
+	float top = v[0] + (v[1] - v[0]) * fx;
+	float bottom = v[m_dimension.x] + (v[m_dimension.x + 1] - v[m_dimension.x]) * fx;
+	return top + (bottom - top) * fy;
+}
+
+sf::Vector2f DistanceField::gradient(sf::Vector2f position) const
+{
+	int id;
+	float fx, fy;
+	locate(position, id, fx, fy);
+	const float* v = m_values.data() + id;
+	const float* w = v + m_dimension.x;
+	// Derivatives of the bilinear patch
+	float dx = (v[1] - v[0]) * (1.f - fy) + (w[1] - w[0]) * fy;
+	float dy = (w[0] - v[0]) * (1.f - fx) + (w[1] - v[1]) * fx;
+	return sf::Vector2f(dx, dy) / m_texel_size;
+}
+
+bool DistanceField::raycast(sf::Vector2f start, sf::Vector2f end, float& time, const ObstacleTree& fallback) const
+{
+	sf::Vector2f dir = end - start;
+	float length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+	float threshold = 0.5f * m_texel_size;
+	if (length == 0.f)
+	{
+		time = 0.f;
+		return distance(start) <= threshold;
+	}
+	dir /= length;
+	float t = 0.f;
+	for (int i = 0; i < MAX_TRACE_STEPS; i++)
+	{
+		if (t > length)
+			return false;
+		float d = distance(start + dir * t);
+		if (d <= threshold)
+		{
+			time = t / length;
+			return true;
+		}
+		t += d;
+	}
+	if (t > length)
+		return false;
+	// Out of steps with the end still ahead, resume with an exact cast from there
+	if (!fallback.raycast(start + dir * t, end, time))
+		return false;
+	time = (t + time * (length - t)) / length;
+	return true;
+}
+
+float DistanceField::getTexelSize() const
+{
+	return m_texel_size;
+}
+
+std::uint64_t DistanceField::makeKey(const ObstacleSet& obstacles, sf::FloatRect area, float texel_size)
+{
+	std::uint64_t key = 14695981039346656037ull;
+	hash(key, VERSION);
+	hash(key, area);
+	hash(key, texel_size);
+	hash(key, obstacles.circleCount());
+	for (int i = 0; i < obstacles.circleCount(); i++)
+		hash(key, obstacles.circleBounds(i));
+	hash(key, obstacles.boxCount());
+	for (int i = 0; i < obstacles.boxCount(); i++)
+		hash(key, obstacles.boxBounds(i));
+	return key;
+}
+
+bool DistanceField::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write(MAGIC, 4);
+	write(file, VERSION);
+	write(file, m_key);
+	write(file, static_cast<std::int32_t>(m_dimension.x));
+	write(file, static_cast<std::int32_t>(m_dimension.y));
+	write(file, m_origin.x);
+	write(file, m_origin.y);
+	write(file, m_texel_size);
+	file.write(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(float));
+	return static_cast<bool>(file);
+}
+
+bool DistanceField::load(const std::string& path, std::uint64_t key)
+{
+	std::ifstream file(path, std::ios::binary);
+	Header header;
+	if (!file.read(header.magic, 4) || !read(file, header.version) || !read(file, header.key)
+		|| !read(file, header.width) || !read(file, header.height)
+		|| !read(file, header.origin_x) || !read(file, header.origin_y) || !read(file, header.texel_size)
+		|| std::memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION || header.key != key
+		|| header.width < 2 || header.height < 2)
+		return false;
+	std::vector<float> values(static_cast<std::size_t>(header.width) * header.height);
+	if (!file.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(float)))
+		return false;
+	m_origin = sf::Vector2f(header.origin_x, header.origin_y);
+	m_texel_size = header.texel_size;
+	m_dimension = sf::Vector2i(header.width, header.height);
+	m_values.swap(values);
+	m_key = key;
+	return true;
+}
+
+void DistanceField::locate(sf::Vector2f position, int& id, float& fx, float& fy) const
+{
+	float x = std::min(std::max((position.x - m_origin.x) / m_texel_size, 0.f), m_dimension.x - 1.f);
+	float y = std::min(std::max((position.y - m_origin.y) / m_texel_size, 0.f), m_dimension.y - 1.f);
+	int ix = std::min(static_cast<int>(x), m_dimension.x - 2);
+	int iy = std::min(static_cast<int>(y), m_dimension.y - 2);
+	fx = x - ix;
+	fy = y - iy;
+	id = iy * m_dimension.x + ix;
+}
@@ -0,0 +1,67 @@
+#ifndef AI_FLOCK_DISTANCE_FIELD
+#define AI_FLOCK_DISTANCE_FIELD
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "ObstacleSet.hpp"
+#include "ObstacleTree.hpp"
+#include "WorkerPool.hpp"
+
+// Signed distance to the nearest obstacle, sampled on a regular grid of texels
+// and read back with bilinear filtering. Negative inside obstacles.
+// Baked once for a static map, proximity queries are then a few texel reads.
+class DistanceField
+{
+public:
+	DistanceField();
+
+	// Samples obstacles at every texel corner of area. Tiles of texels are split over
+	// pool, and each one only measures the shapes of tree that can be nearest to it.
+	// tree must be built from obstacles.
+	void build(const ObstacleSet& obstacles, const ObstacleTree& tree, sf::FloatRect area, float texel_size,
+		WorkerPool& pool);
+
+	// Loads cache_path if it was baked from the same obstacles and settings,
+	// otherwise builds the field and saves it there. An empty cache_path only
+	// builds. Returns true on a cache hit.
+	bool buildCached(const ObstacleSet& obstacles, const ObstacleTree& tree, sf::FloatRect area, float texel_size,
+		WorkerPool& pool, const std::string& cache_path);
+
+	bool empty() const;
+
+	// Positions outside the baked area read the nearest edge texel
+	float distance(sf::Vector2f position) const;
+
+	// Gradient of the filtered distance, points away from the nearest obstacle
+	sf::Vector2f gradient(sf::Vector2f position) const;
+
+	// Sphere traces the segment from start to end, same contract as ObstacleTree::raycast.
+	// Rays passing within half a texel of an obstacle count as hits. Rays still short
+	// of end after MAX_TRACE_STEPS, grazing along a wall, are cast against fallback.
+	bool raycast(sf::Vector2f start, sf::Vector2f end, float& time, const ObstacleTree& fallback) const;
+
+	float getTexelSize() const;
+private:
+	static std::uint64_t makeKey(const ObstacleSet& obstacles, sf::FloatRect area, float texel_size);
+
+	// Cache files are a packed header and raw floats, native-endian: only meant for
+	// the machine that wrote them
+	bool save(const std::string& path) const;
+
+	bool load(const std::string& path, std::uint64_t key);
+
+	// Texel of position and the weights of its right and bottom neighbours
+	void locate(sf::Vector2f position, int& id, float& fx, float& fy) const;
+private:
+	sf::Vector2f m_origin;
+	float m_texel_size;
+	sf::Vector2i m_dimension;
+	std::vector<float> m_values;
+	std::uint64_t m_key;
+};
+
+#endif
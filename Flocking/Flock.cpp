@@ -0,0 +1,626 @@
+#include "Flock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Dense cell tables past this size are replaced by hashed buckets
+	const long long MAX_DENSE_CELLS = 1 << 22;
+	// Largest distance field useDistanceField will bake
+	const long long MAX_FIELD_TEXELS = 1 << 26;
+	// Initial cell size, in boid visions
+	const float CELL_SCALE = 1.25f;
+	// Cell sizes the tuning picks from, in boid visions
+	const float CELL_STEPS[] = { 0.5f, 0.625f, 0.75f, 1.f, 1.25f, 1.5f, 2.f };
+	// Visiting a cell, in candidate tests
+	const float CELL_COST = 8.f;
+	// Share of the predicted cost a new cell size has to save
+	const float TUNE_HYSTERESIS = 0.2f;
+
+	int hashedBuckets(float cell_size, sf::Vector2f world_size, int boid_count)
+	{
+		long long cells = static_cast<long long>(std::max(1.f, std::floor(world_size.x / cell_size)))
+			* static_cast<long long>(std::max(1.f, std::floor(world_size.y / cell_size)));
+		return cells > MAX_DENSE_CELLS ? std::max(4096, 2 * boid_count) : 0;
+	}
+
+	// Spreads the low 16 bits of v over the even bits
+	std::uint32_t spreadBits(std::uint32_t v)
+	{
+		v &= 0xffff;
+		v = (v | (v << 8)) & 0x00ff00ff;
+		v = (v | (v << 4)) & 0x0f0f0f0f;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	std::uint32_t mortonCode(sf::Vector2i cell)
+	{
+		return spreadBits(static_cast<std::uint32_t>(cell.x)) | spreadBits(static_cast<std::uint32_t>(cell.y)) << 1;
+	}
+}
+
+Flock::Flock(int size, sf::RenderWindow* win, int boid_vision, int thread_count, int obstacle_count, sf::Vector2f world_size,
+	std::uint64_t seed)
+	: m_window(win)
+	, m_boid_vision(boid_vision)
+	, m_index_mode(INCREMENTAL)
+	, m_grid(CELL_SCALE * boid_vision, world_size, hashedBuckets(CELL_SCALE * boid_vision, world_size, size))
+	, m_moving_grid(CELL_SCALE * boid_vision, world_size, hashedBuckets(CELL_SCALE * boid_vision, world_size, size))
+	, m_seed(seed)
+	, m_random(seed)
+	, m_obstacle_random(seed, OBSTACLE_STREAM)
+	, m_populated(0)
+	, m_pool(std::make_unique<WorkerPool>(thread_count))
+	, m_nearest_count(0)
+	, m_tick(0)
+	, m_lod_interval(1)
+	, m_lod_radius(0.f)
+	, m_lod_phases(0)
+	, m_auto_cell(false)
+	, m_grid_stats()
+	, m_reorder_interval(60)
+	, m_active_radius(0.f)
+	, m_despawned_parked(0)
+{
+	sf::Vector2f scale(world_size.x / 1000.f, world_size.y / 1000.f);
+	float radius_scale = std::min(scale.x, scale.y);
+	auto place = [&](float x, float y) { return sf::Vector2f(x * scale.x, y * scale.y); };
+	auto area = [&](float x, float y, float w, float h) { return sf::FloatRect(place(x, y), place(w, h)); };
+	addCircle(100 * radius_scale, place(500, 500));
+	addCircle(50 * radius_scale, place(300, 700));
+	addCircle(70 * radius_scale, place(400, 200));
+	addRectangle(area(800, 100, 30, 300));
+	addRectangle(area(0, -50, 1000, 100));
+	addRectangle(area(950, 0, 100, 1000));
+	addRectangle(area(-50, 0, 100, 1000));
+	addRectangle(area(0, 950, 1000, 100));
+	for (int i = 0; i < obstacle_count; i++)
+	{
+		sf::Vector2f pos = place(m_random.uniform(50.f, 950.f), m_random.uniform(50.f, 950.f));
+		if (i % 2)
+			addCircle(m_random.uniform(5.f, 25.f), pos);
+		else
+			addRectangle(sf::FloatRect(pos, sf::Vector2f(m_random.uniform(5.f, 35.f), m_random.uniform(5.f, 35.f))));
+	}
+	m_collider_tree.build(m_obstacles);
+
+	for (int i = 0; i < SPECIES_COUNT; i++)
+	{
+		sf::Color color(m_random.below(256), m_random.below(256), m_random.below(256));
+		addArchetype(BoidArchetype(m_random.uniform(800.f, 1100.f), m_random.uniform(100.f, 300.f),
+			m_boid_vision, 130, 2.f * m_boid_vision, 10.f, color));
+	}
+
+	m_store.setWorldSize(world_size);
+	m_next.setWorldSize(world_size);
+	m_free_space.build(m_obstacles, world_size, FREE_CELLS, *m_pool);
+	populate(size);
+}
+
+void Flock::update(sf::Time dt)
+{
+	int count = static_cast<int>(m_boids.size());
+	if (m_index_mode == INCREMENTAL)
+		m_moving_grid.update(m_store.positionX(), m_store.positionY(), count);
+	else
+		m_grid.rebuild(m_store.positionX(), m_store.positionY(), count);
+	const CellLayout& layout = m_grid.getLayout();
+	m_next.resize(count);
+
+	m_scratch.resize(m_pool->size());
+	m_nearest.resize(m_pool->size());
+	if (m_query_counts.size() < m_scratch.size())
+		m_query_counts.resize(m_scratch.size(), QueryCount{ 0, 0, 0 });
+	float lod_radius_sq = m_lod_radius * m_lod_radius;
+
+	m_pool->parallelFor(count, 64, [&](int first, int last, int worker)
+		{
+			std::vector<int>& neighbours = m_scratch[worker];
+			QueryCount counted = { 0, 0, 0 };
+			for (int i = first; i < last; i++)
+			{
+				Boid& boid = m_boids[i];
+				const BoidArchetype& type = m_archetypes[boid.getArchetype()];
+				boid.turnOff();
+				boid.setThruster(true, 1.f);
+				bool full = m_lod_interval <= 1
+					|| (static_cast<std::uint32_t>(m_tick) + m_lod_phase[i]) % static_cast<std::uint32_t>(m_lod_interval) == 0;
+				if (!full && !m_isolated[i])
+				{
+					sf::Vector2f offset = boid.getPosition() - m_lod_focus;
+					full = offset.x * offset.x + offset.y * offset.y <= lod_radius_sq;
+				}
+				if (full)
+				{
+					Grid::Range range;
+					if (m_nearest_count > 0)
+					{
+						NearestNeighbours& nearest = m_nearest[worker];
+						counted.candidates += gatherNearest(i, boid.getPosition(), type.cone, neighbours, nearest);
+						range = Grid::Range{ nearest.ids, nearest.ids + nearest.count };
+					}
+					else
+					{
+						if (m_index_mode == INCREMENTAL)
+							m_moving_grid.gather(boid.getPosition(), neighbours);
+						else
+							m_grid.gather(boid.getPosition(), neighbours);
+						counted.candidates += neighbours.size();
+						range = Grid::Range{ neighbours.data(), neighbours.data() + neighbours.size() };
+					}
+					int visible = boid.updateData(m_store, i, range, type);
+					m_isolated[i] = visible == 0;
+					counted.queries++;
+					counted.visible += visible;
+				}
+				else
+					boid.reuseSteering();
+				if (m_field.empty())
+					boid.updateFeeler(m_collider_tree, type);
+				else
+					boid.updateFeeler(m_field, m_collider_tree, type);
+				boid.update(dt, type);
+				sf::Vector2f pos = layout.wrap(boid.getPosition());
+				boid.setPosition(pos);
+				m_next.write(i, pos, boid.getHeading().getDirection(), boid.getSpeed());
+			}
+			m_query_counts[worker].queries += counted.queries;
+			m_query_counts[worker].candidates += counted.candidates;
+			m_query_counts[worker].visible += counted.visible;
+		});
+	std::swap(m_store, m_next);
+	m_tick++;
+	if (m_tick % TUNE_INTERVAL == 0)
+		tune();
+	if (m_reorder_interval > 0 && m_tick % m_reorder_interval == 0)
+		reorder();
+	if (m_chunks && m_tick % PAGE_INTERVAL == 0)
+		page();
+}
+
+void Flock::setLevelOfDetail(int interval, sf::Vector2f focus, float radius)
+{
+	m_lod_interval = std::max(1, interval);
+	m_lod_focus = focus;
+	m_lod_radius = radius;
+}
+
+bool Flock::useDistanceField(float texel_size, const std::string& cache_path)
+{
+	// Margin for the feelers of boids at the edges of the world
+	float margin = 2.f * CELL_SCALE * m_boid_vision;
+	sf::Vector2f world = m_grid.getLayout().getWorldSize();
+	sf::FloatRect area(-margin, -margin, world.x + 2.f * margin, world.y + 2.f * margin);
+	if ((area.width / texel_size + 1) * (area.height / texel_size + 1) > MAX_FIELD_TEXELS)
+		return false;
+	return m_field.buildCached(m_obstacles, m_collider_tree, area, texel_size, *m_pool, cache_path);
+}
+
+void Flock::setActiveRegion(sf::Vector2f centre, float radius, float chunk_size)
+{
+	if (!m_chunks)
+		m_chunks = std::make_unique<ChunkedWorld>(chunk_size, getWorldSize());
+	m_active_centre = centre;
+	m_active_radius = radius;
+	page();
+}
+
+int Flock::addArchetype(const BoidArchetype& archetype)
+{
+	m_archetypes.push_back(archetype);
+	return getArchetypeCount() - 1;
+}
+
+int Flock::getArchetypeCount() const
+{
+	return static_cast<int>(m_archetypes.size());
+}
+
+void Flock::populate(int count)
+{
+	if (count <= 0 || m_archetypes.empty())
+		return;
+	int first = getBoidCount();
+	// Handles first, the arrays only grow by the boids that got one
+	int added = 0;
+	while (added < count && m_ids.insert() != SlotMap::NONE)
+		added++;
+	count = added;
+	if (count == 0)
+		return;
+	m_boids.resize(first + count);
+	m_isolated.resize(first + count, 0);
+	m_lod_phase.resize(first + count);
+	m_store.resize(first + count);
+	for (int i = first; i < first + count; i++)
+		m_lod_phase[i] = m_lod_phases++;
+	std::uint64_t stream = m_populated + 1;
+	m_populated += count;
+	sf::Vector2f world = getWorldSize();
+	m_pool->parallelFor(count, 4096, [&](int begin, int end, int)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				Utilise::Random random(m_seed, stream + i);
+				Boid boid(static_cast<std::uint16_t>(random.below(getArchetypeCount())));
+				boid.setHeading(Utilise::Heading(random.uniform(0.f, 360.f)));
+				if (m_free_space.empty())
+					boid.setPosition(sf::Vector2f(random.uniform(0.f, world.x), random.uniform(0.f, world.y)));
+				else
+					boid.setPosition(m_free_space.sample(random));
+				m_boids[first + i] = boid;
+				m_store.write(first + i, boid.getPosition(), boid.getHeading().getDirection(), boid.getSpeed());
+			}
+		});
+	if (m_chunks)
+		page();
+}
+
+SlotMap::Handle Flock::spawn(sf::Vector2f position, const Utilise::Heading& heading)
+{
+	return spawn(position, heading, m_random.below(getArchetypeCount()));
+}
+
+SlotMap::Handle Flock::spawn(sf::Vector2f position, const Utilise::Heading& heading, int archetype)
+{
+	if (archetype < 0 || archetype >= getArchetypeCount())
+		return SlotMap::NONE;
+	Boid boid(static_cast<std::uint16_t>(archetype));
+	boid.setPosition(m_grid.getLayout().wrap(position));
+	boid.setHeading(heading);
+	SlotMap::Handle id;
+	if (m_chunks && !m_chunks->overlaps(m_chunks->chunkOf(boid.getPosition()), m_active_centre, m_active_radius))
+	{
+		id = m_ids.insertDetached();
+		if (id != SlotMap::NONE)
+			m_chunks->park(boid, id);
+	}
+	else
+	{
+		id = m_ids.insert();
+		if (id != SlotMap::NONE)
+			addBoid(boid);
+	}
+	return id;
+}
+
+void Flock::despawn(SlotMap::Handle id)
+{
+	bool parked = m_ids.contains(id) && m_ids.indexOf(id) < 0;
+	int slot = m_ids.erase(id);
+	if (slot >= 0)
+		removeBoid(slot);
+	else if (parked)
+		m_despawned_parked++;
+}
+
+const Boid* Flock::find(SlotMap::Handle id) const
+{
+	int slot = m_ids.indexOf(id);
+	return slot < 0 ? nullptr : &m_boids[slot];
+}
+
+void Flock::setReorderInterval(int interval)
+{
+	m_reorder_interval = std::max(0, interval);
+}
+
+void Flock::setCellSize(float cell_size)
+{
+	cell_size = std::max(cell_size, 0.5f * m_boid_vision);
+	int reach = cell_size >= m_boid_vision ? 1 : 2;
+	sf::Vector2f world = getWorldSize();
+	int buckets = hashedBuckets(cell_size, world, getBoidCount());
+	m_grid = Grid(cell_size, world, buckets, reach);
+	m_moving_grid = IncrementalGrid(cell_size, world, buckets, reach);
+}
+
+float Flock::getCellSize() const
+{
+	return m_grid.getLayout().getCellSize().x;
+}
+
+void Flock::setAutoCellSize(bool enable)
+{
+	m_auto_cell = enable;
+}
+
+const Flock::GridStats& Flock::getGridStats() const
+{
+	return m_grid_stats;
+}
+
+void Flock::setNearestCount(int k)
+{
+	k = std::min(std::max(k, 0), static_cast<int>(NearestNeighbours::MAX_COUNT));
+	if ((k > 0) != (m_nearest_count > 0))
+		setCellSize((k > 0 ? CELL_STEPS[0] : CELL_SCALE) * m_boid_vision);
+	m_nearest_count = k;
+}
+
+int Flock::getNearestCount() const
+{
+	return m_nearest_count;
+}
+
+void Flock::setIndexMode(IndexMode mode)
+{
+	if (mode == INCREMENTAL && m_index_mode != INCREMENTAL)
+		m_moving_grid.clear();
+	m_index_mode = mode;
+}
+
+Flock::IndexMode Flock::getIndexMode() const
+{
+	return m_index_mode;
+}
+
+int Flock::getMigrationCount() const
+{
+	return m_index_mode == INCREMENTAL ? m_moving_grid.getMigrationCount() : 0;
+}
+
+void Flock::setThreadCount(int thread_count)
+{
+	m_pool = std::make_unique<WorkerPool>(thread_count);
+}
+
+int Flock::getThreadCount() const
+{
+	return m_pool->size();
+}
+
+int Flock::getBoidCount() const
+{
+	return static_cast<int>(m_boids.size());
+}
+
+int Flock::getParkedCount() const
+{
+	return m_chunks ? m_chunks->getParkedCount() - m_despawned_parked : 0;
+}
+
+int Flock::getChunkCount() const
+{
+	return m_chunks ? m_chunks->getChunkCount() : 0;
+}
+
+sf::Vector2f Flock::getWorldSize() const
+{
+	return m_grid.getLayout().getWorldSize();
+}
+
+void Flock::render()
+{
+	for (int i = 0; i < m_colliders.size(); i++)
+		m_window->draw(*m_colliders[i]);
+	m_renderer.render(*m_window, m_boids, m_archetypes, *m_pool);
+}
+
+void Flock::record(TraceWriter& trace) const
+{
+	for (int i = 0; i < m_ids.getSlotCount(); i++)
+	{
+		SlotMap::Handle id = m_ids.handleOfSlot(i);
+		int slot = m_ids.indexOf(id);
+		if (slot >= 0)
+		{
+			const Boid& boid = m_boids[slot];
+			trace.add(id, boid.getPosition(), boid.getHeading(), boid.getSpeed(), boid.getState());
+		}
+	}
+	trace.endFrame();
+}
+
+void Flock::restore(const std::vector<TraceEntity>& frame)
+{
+	for (const TraceEntity& entity : frame)
+	{
+		int slot = m_ids.indexOf(entity.id);
+		if (slot < 0)
+			continue;
+		m_boids[slot].setPosition(entity.position);
+		m_boids[slot].setHeading(entity.heading);
+	}
+}
+
+void Flock::addBoid(const Boid& boid)
+{
+	int slot = getBoidCount();
+	m_boids.push_back(boid);
+	m_isolated.push_back(0);
+	m_lod_phase.push_back(m_lod_phases++);
+	m_store.resize(slot + 1);
+	m_store.write(slot, boid.getPosition(), boid.getHeading().getDirection(), boid.getSpeed());
+}
+
+void Flock::removeBoid(int slot)
+{
+	int last = getBoidCount() - 1;
+	if (slot != last)
+	{
+		m_boids[slot] = m_boids[last];
+		m_isolated[slot] = m_isolated[last];
+		m_lod_phase[slot] = m_lod_phase[last];
+		m_store.write(slot, m_boids[slot].getPosition(), m_boids[slot].getHeading().getDirection(), m_boids[slot].getSpeed());
+	}
+	m_boids.pop_back();
+	m_isolated.pop_back();
+	m_lod_phase.pop_back();
+	m_store.resize(last);
+}
+
+void Flock::reorder()
+{
+	int count = getBoidCount();
+	const CellLayout& layout = m_grid.getLayout();
+	m_sort_keys.resize(count);
+	m_sort_order.resize(count);
+	m_pool->parallelFor(count, 4096, [&](int first, int last, int)
+		{
+			for (int i = first; i < last; i++)
+			{
+				m_sort_keys[i] = mortonCode(layout.cellOf(m_boids[i].getPosition()));
+				m_sort_order[i] = static_cast<std::uint32_t>(i);
+			}
+		});
+	m_sorter.sort(m_sort_keys, m_sort_order, *m_pool);
+
+	// m_store mirrors the boids between updates, so it is written again from them
+	m_sorted_boids.resize(count);
+	m_sorted_isolated.resize(count);
+	m_sorted_lod_phase.resize(count);
+	m_pool->parallelFor(count, 4096, [&](int first, int last, int)
+		{
+			for (int i = first; i < last; i++)
+			{
+				int from = static_cast<int>(m_sort_order[i]);
+				const Boid& boid = m_boids[from];
+				m_sorted_boids[i] = boid;
+				m_sorted_isolated[i] = m_isolated[from];
+				m_sorted_lod_phase[i] = m_lod_phase[from];
+				m_store.write(i, boid.getPosition(), boid.getHeading().getDirection(), boid.getSpeed());
+			}
+		});
+	m_boids.swap(m_sorted_boids);
+	m_isolated.swap(m_sorted_isolated);
+	m_lod_phase.swap(m_sorted_lod_phase);
+	m_ids.reorder(m_sort_order.data());
+	// Every index moved
+	m_moving_grid.clear();
+}
+
+void Flock::page()
+{
+	// Backwards, so the boid swapped into a freed index has already been checked
+	for (int i = getBoidCount() - 1; i >= 0; i--)
+	{
+		sf::Vector2i chunk = m_chunks->chunkOf(m_boids[i].getPosition());
+		if (!m_chunks->overlaps(chunk, m_active_centre, m_active_radius))
+		{
+			SlotMap::Handle id = m_ids.handleAt(i);
+			m_ids.detach(id);
+			m_chunks->park(m_boids[i], id);
+			removeBoid(i);
+		}
+	}
+
+	std::vector<ChunkedWorld::ParkedBoid> woken;
+	m_chunks->unpark(m_active_centre, m_active_radius, woken);
+	for (auto& i : woken)
+	{
+		// Despawned while parked
+		if (!m_ids.attach(i.id))
+		{
+			m_despawned_parked--;
+			continue;
+		}
+		Boid boid(i.archetype);
+		boid.setPosition(i.position);
+		boid.setHeading(i.heading);
+		boid.setSpeed(i.speed);
+		addBoid(boid);
+	}
+}
+
+void Flock::tune()
+{
+	QueryCount total = { 0, 0, 0 };
+	for (auto& i : m_query_counts)
+	{
+		total.queries += i.queries;
+		total.candidates += i.candidates;
+		total.visible += i.visible;
+		i = QueryCount{ 0, 0, 0 };
+	}
+	const CellLayout& layout = m_grid.getLayout();
+	CellOccupancy occupancy = m_index_mode == INCREMENTAL ? m_moving_grid.getOccupancy() : m_grid.getOccupancy();
+	m_grid_stats.cell_size = getCellSize();
+	m_grid_stats.reach = layout.getReach();
+	m_grid_stats.mean_occupancy = occupancy.occupied == 0 ? 0.f : getBoidCount() / static_cast<float>(occupancy.occupied);
+	m_grid_stats.max_occupancy = occupancy.largest;
+	float queries = static_cast<float>(std::max(1LL, total.queries));
+	m_grid_stats.candidates = total.candidates / queries;
+	m_grid_stats.visible = total.visible / queries;
+	m_grid_stats.candidate_ratio = total.candidates / static_cast<float>(std::max(1LL, total.visible));
+	// The cost model assumes whole blocks are scanned, which topological queries avoid
+	if (!m_auto_cell || m_nearest_count > 0 || total.queries == 0)
+		return;
+
+	// Scanned area grows with the square of the cell size, the number of cells visited with the reach
+	sf::Vector2f cell = layout.getCellSize();
+	sf::Vector2i span(
+		std::min(layout.getDimension().x, 2 * layout.getReach() + 1),
+		std::min(layout.getDimension().y, 2 * layout.getReach() + 1));
+	float density = m_grid_stats.candidates / (span.x * span.y * cell.x * cell.y);
+	auto cost = [&](float size, int reach)
+	{
+		float side = 2.f * reach + 1.f;
+		return side * side * (CELL_COST + density * size * size);
+	};
+	float current = cost(std::sqrt(cell.x * cell.y), layout.getReach());
+	float best = current, best_size = 0.f;
+	for (float step : CELL_STEPS)
+	{
+		float size = step * m_boid_vision;
+		float predicted = cost(size, step < 1.f ? 2 : 1);
+		if (predicted < best)
+		{
+			best = predicted;
+			best_size = size;
+		}
+	}
+	if (best_size > 0.f && best < (1.f - TUNE_HYSTERESIS) * current)
+		setCellSize(best_size);
+}
+
+int Flock::gatherNearest(int self, sf::Vector2f position, const ViewCone& cone,
+	std::vector<int>& candidates, NearestNeighbours& nearest) const
+{
+	nearest.reset(m_nearest_count);
+	const CellLayout& layout = m_grid.getLayout();
+	if (!layout.hasRings())
+	{
+		if (m_index_mode == INCREMENTAL)
+			m_moving_grid.gather(position, candidates);
+		else
+			m_grid.gather(position, candidates);
+		m_store.selectNearest(self, candidates.data(), candidates.data() + candidates.size(), cone, nearest);
+		return static_cast<int>(candidates.size());
+	}
+	int scanned = 0;
+	for (int ring = 0; ring <= layout.getReach(); ring++)
+	{
+		if (m_index_mode == INCREMENTAL)
+			m_moving_grid.gatherRing(position, ring, candidates);
+		else
+			m_grid.gatherRing(position, ring, candidates);
+		scanned += static_cast<int>(candidates.size());
+		m_store.selectNearest(self, candidates.data(), candidates.data() + candidates.size(), cone, nearest);
+		// Every cell further out is at least this far away
+		float clearance = layout.ringClearance(position, ring);
+		if (clearance >= cone.radius || (nearest.full() && nearest.farthest() <= clearance * clearance))
+			break;
+	}
+	return scanned;
+}
+
+void Flock::addCircle(float radius, sf::Vector2f position)
+{
+	m_colliders.push_back(std::make_unique<Circle>(radius, position, nextObstacleColor()));
+	m_obstacles.addCircle(position, radius);
+}
+
+sf::Color Flock::nextObstacleColor()
+{
+	return sf::Color(m_obstacle_random.below(256), m_obstacle_random.below(256), m_obstacle_random.below(256));
+}
+
+void Flock::addRectangle(sf::FloatRect bound)
+{
+	m_colliders.push_back(std::make_unique<Rectangle>(bound, nextObstacleColor()));
+	m_obstacles.addBox(bound);
+}
@@ -0,0 +1,277 @@
+#ifndef AI_FLOCK_FLOCK
+#define AI_FLOCK_FLOCK
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Boid.hpp"
+#include "Obstacle.hpp"
+#include "ObstacleSet.hpp"
+#include "ObstacleTree.hpp"
+#include "DistanceField.hpp"
+#include "Grid.hpp"
+#include "IncrementalGrid.hpp"
+#include "ChunkedWorld.hpp"
+#include "FreeSpace.hpp"
+#include "BoidStore.hpp"
+#include "WorkerPool.hpp"
+#include "FlockRenderer.hpp"
+#include "Trace.hpp"
+#include "Random.hpp"
+#include "RadixSort.hpp"
+#include "SlotMap.hpp"
+
+class Flock
+{
+public:
+	// How the neighbour index follows the boids
+	enum IndexMode
+	{
+		// Counting sort of every boid each tick
+		REBUILD,
+		// Only boids that changed cell are moved
+		INCREMENTAL
+	};
+
+	// Neighbour index statistics, refreshed every TUNE_INTERVAL ticks
+	struct GridStats
+	{
+		float cell_size;
+		// Rings of cells gathered around a boid
+		int reach;
+		// Boids per occupied cell, and in the fullest one
+		float mean_occupancy;
+		int max_occupancy;
+		// Averages per neighbour evaluation since the last refresh
+		float candidates;
+		float visible;
+		// Candidates gathered per visible neighbour
+		float candidate_ratio;
+	};
+public:
+	// win may be null when the flock is never rendered.
+	// obstacle_count random obstacles are scattered on top of the fixed map.
+	// thread_count <= 0 uses every hardware thread.
+	// The world is periodic, boids leaving one edge come back from the opposite one.
+	// The fixed map is laid out for 1000 x 1000 and scaled to world_size.
+	// Worlds with too many cells to store index boids through hashed buckets.
+	// The map, the species and every random spawn only depend on seed.
+	Flock(int size, sf::RenderWindow* win, int boid_vision, int thread_count = 0, int obstacle_count = 0,
+		sf::Vector2f world_size = sf::Vector2f(1000.f, 1000.f), std::uint64_t seed = 0);
+
+	// Each boid steers from the previous tick's snapshot in m_store and writes
+	// its new state into m_next, so boids can be split freely between threads
+	// and the result does not depend on the thread count.
+	void update(sf::Time dt);
+
+	// Boids outside radius of focus, or that saw no neighbour last time, only
+	// re-evaluate neighbour steering every interval ticks, in staggered buckets,
+	// and keep the last turn in between. Feelers and movement run every tick.
+	// An interval of 1 evaluates every boid every tick.
+	void setLevelOfDetail(int interval, sf::Vector2f focus, float radius);
+
+	// Bakes a distance field of the obstacles for the feelers, in place of ray casts
+	// against m_collider_tree. A non-empty cache_path is loaded when it matches the
+	// map and written otherwise. Returns true on a cache hit.
+	// Worlds too large to bake keep the ray casts.
+	bool useDistanceField(float texel_size, const std::string& cache_path = "");
+
+	// Splits the world into chunks of chunk_size and only simulates boids in chunks
+	// within radius of centre. Every PAGE_INTERVAL ticks, boids that left the region
+	// are parked in their chunk in a compact form, and chunks that entered it are
+	// woken up. The chunk size is fixed by the first call.
+	void setActiveRegion(sf::Vector2f centre, float radius, float chunk_size = 1024.f);
+
+	// Registers a new species, returns its index for spawn
+	int addArchetype(const BoidArchetype& archetype);
+
+	int getArchetypeCount() const;
+
+	// Adds count boids of random species at random points clear of obstacles, filled in
+	// parallel. The n-th boid placed this way draws from its own stream of the seed,
+	// so the result does not depend on the thread count. Boids outside the active
+	// region are parked straight away. Stops early once m_ids has no handle left.
+	void populate(int count);
+
+	// Adds a boid of a random species, parked if it lands outside the active region.
+	// Returns its handle, which stays valid while the storage is reordered or paged.
+	SlotMap::Handle spawn(sf::Vector2f position, const Utilise::Heading& heading);
+
+	// Same with a given species, returns SlotMap::NONE if it does not exist
+	SlotMap::Handle spawn(sf::Vector2f position, const Utilise::Heading& heading, int archetype);
+
+	// Removes a boid, its handle goes stale. A parked boid stays in its chunk until
+	// the chunk wakes up, where it is dropped because its handle no longer attaches.
+	void despawn(SlotMap::Handle id);
+
+	// Null unless the boid is active. Only valid until the next update.
+	const Boid* find(SlotMap::Handle id) const;
+
+	// Every interval ticks, sorts the boid storage by the Morton code of each boid's
+	// cell, so boids that are close in the world are close in memory during neighbour
+	// scans. 0 keeps the current order, the default is 60.
+	void setReorderInterval(int interval);
+
+	// Cells are at least cell_size wide, and at least half the boid vision. Cells
+	// narrower than the vision are gathered two rings deep. The index is filled again
+	// on the next update.
+	void setCellSize(float cell_size);
+
+	float getCellSize() const;
+
+	// Every TUNE_INTERVAL ticks, estimates the scan cost of each cell size from the
+	// density of candidates the boids actually gathered, so clusters weigh in, and
+	// switches when the best one is at least a fifth cheaper than the current one.
+	void setAutoCellSize(bool enable);
+
+	const GridStats& getGridStats() const;
+
+	// Topological mode: with k > 0 each boid steers from its k nearest visible neighbours
+	// only, at most NearestNeighbours::MAX_COUNT, so crowding no longer adds to its cost.
+	// Cells are scanned ring by ring and the scan stops once no further cell can hold a
+	// closer boid, so the grid switches to its finest cells and the automatic cell size
+	// is suspended. 0 uses every visible neighbour and restores the default cell size.
+	void setNearestCount(int k);
+
+	int getNearestCount() const;
+
+	void setIndexMode(IndexMode mode);
+
+	IndexMode getIndexMode() const;
+
+	// Boids that changed cell during the last tick, only counted in INCREMENTAL mode
+	int getMigrationCount() const;
+
+	void setThreadCount(int thread_count);
+
+	int getThreadCount() const;
+
+	// Active boids only
+	int getBoidCount() const;
+
+	int getParkedCount() const;
+
+	// Chunks holding parked boids
+	int getChunkCount() const;
+
+	sf::Vector2f getWorldSize() const;
+
+	void render();
+
+	// Adds one frame with every active boid to trace, in slot order, each with its handle
+	void record(TraceWriter& trace) const;
+
+	// Moves the boids to a recorded frame by handle, for replays. A flock built with the
+	// same seed and size hands out the same handles. Entities without an active boid
+	// here are skipped, boids missing from the frame are left alone.
+	void restore(const std::vector<TraceEntity>& frame);
+private:
+	static const int PAGE_INTERVAL = 30;
+	// Species built by the constructor
+	static const int SPECIES_COUNT = 16;
+	// Resolution of the free space spawns are drawn from
+	static const int FREE_CELLS = 1 << 16;
+	// Last stream of the seed, populate never gets that far
+	static const std::uint64_t OBSTACLE_STREAM = ~0ull;
+	static const int TUNE_INTERVAL = 60;
+
+	// Neighbour evaluations of one worker
+	struct QueryCount
+	{
+		long long queries;
+		long long candidates;
+		long long visible;
+	};
+private:
+	// Appends to the dense arrays, the caller binds a handle to the new index in m_ids
+	void addBoid(const Boid& boid);
+
+	// The last boid takes the slot. The caller has already erased or detached its handle.
+	void removeBoid(int slot);
+
+	void reorder();
+
+	void page();
+
+	// Refreshes m_grid_stats and adapts the cell size
+	void tune();
+
+	// Fills nearest for the boid self at position, returns the number of candidates scanned
+	int gatherNearest(int self, sf::Vector2f position, const ViewCone& cone,
+		std::vector<int>& candidates, NearestNeighbours& nearest) const;
+
+	void addCircle(float radius, sf::Vector2f position);
+
+	void addRectangle(sf::FloatRect bound);
+
+	// Next fill colour from m_obstacle_random
+	sf::Color nextObstacleColor();
+private:
+	sf::RenderWindow* m_window;
+	int m_boid_vision;
+	// Shared by every boid of a species, boids only hold an index
+	std::vector<BoidArchetype> m_archetypes;
+	std::vector<Boid> m_boids;
+	// Handle of every boid, in step with m_boids. Parked boids keep theirs detached.
+	SlotMap m_ids;
+	// Either index also owns the layout of the world
+	IndexMode m_index_mode;
+	Grid m_grid;
+	IncrementalGrid m_moving_grid;
+	// Read-only during update
+	BoidStore m_store;
+	BoidStore m_next;
+	FlockRenderer m_renderer;
+	// Drawables only, ray queries use m_collider_tree
+	std::vector<std::unique_ptr<Obstacle>> m_colliders;
+	ObstacleSet m_obstacles;
+	ObstacleTree m_collider_tree;
+	// Empty unless useDistanceField was called
+	DistanceField m_field;
+	FreeSpace m_free_space;
+	// Stream 0 of the seed, populate uses the following ones
+	std::uint64_t m_seed;
+	Utilise::Random m_random;
+	// Obstacle colours, kept apart so they do not shift the layout or the boids
+	Utilise::Random m_obstacle_random;
+	std::uint64_t m_populated;
+	std::unique_ptr<WorkerPool> m_pool;
+	// Neighbour candidates and topological selections, one per worker
+	std::vector<std::vector<int>> m_scratch;
+	int m_nearest_count;
+	std::vector<NearestNeighbours> m_nearest;
+	// Level of detail
+	int m_tick;
+	int m_lod_interval;
+	sf::Vector2f m_lod_focus;
+	float m_lod_radius;
+	// Set when a boid saw no neighbour at its last evaluation
+	std::vector<char> m_isolated;
+	// Bucket offset of every boid, follows it when it moves to another index
+	std::vector<std::uint32_t> m_lod_phase;
+	std::uint32_t m_lod_phases;
+	// Cell size tuning, one count per worker
+	bool m_auto_cell;
+	std::vector<QueryCount> m_query_counts;
+	GridStats m_grid_stats;
+	// Morton reordering and its scratch arrays
+	int m_reorder_interval;
+	RadixSort m_sorter;
+	std::vector<std::uint32_t> m_sort_keys;
+	std::vector<std::uint32_t> m_sort_order;
+	std::vector<Boid> m_sorted_boids;
+	std::vector<char> m_sorted_isolated;
+	std::vector<std::uint32_t> m_sorted_lod_phase;
+	// Paging, null until setActiveRegion
+	std::unique_ptr<ChunkedWorld> m_chunks;
+	sf::Vector2f m_active_centre;
+	float m_active_radius;
+	// Despawned while parked, still held by a chunk
+	int m_despawned_parked;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "FlockRenderer.hpp"
+
+FlockRenderer::FlockRenderer()
+	: m_buffer(sf::Triangles, sf::VertexBuffer::Stream)
+{ }
+
+void FlockRenderer::render(sf::RenderTarget& target, const std::vector<Boid>& boids,
+	const std::vector<BoidArchetype>& archetypes, WorkerPool& pool)
+{
+	std::size_t count = boids.size() * BoidArchetype::VERTEX_COUNT;
+	if (count == 0)
+		return;
+	m_staging.resize(count);
+	pool.parallelFor(static_cast<int>(boids.size()), 1024, [&](int first, int last, int)
+		{
+			for (int i = first; i < last; i++)
+				boids[i].writeVertices(&m_staging[i * BoidArchetype::VERTEX_COUNT], archetypes[boids[i].getArchetype()]);
+		});
+
+	if (!sf::VertexBuffer::isAvailable())
+	{
+		target.draw(m_staging.data(), count, sf::Triangles);
+		return;
+	}
+	// Only reallocated when the flock changes size
+	if (m_buffer.getVertexCount() != count)
+		m_buffer.create(count);
+	m_buffer.update(m_staging.data());
+	target.draw(m_buffer);
+}
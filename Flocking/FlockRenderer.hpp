@@ -0,0 +1,27 @@
+#ifndef AI_FLOCK_RENDERER
+#define AI_FLOCK_RENDERER
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Boid.hpp"
+#include "WorkerPool.hpp"
+
+// Draws a flock from one persistent vertex buffer. Vertices are built in
+// parallel into a staging array that is uploaded with a single update().
+class FlockRenderer
+{
+public:
+	FlockRenderer();
+
+	// Each boid is drawn with the mesh of its entry in archetypes
+	void render(sf::RenderTarget& target, const std::vector<Boid>& boids,
+		const std::vector<BoidArchetype>& archetypes, WorkerPool& pool);
+private:
+	// Falls back to drawing m_staging directly without vertex buffer support
+	sf::VertexBuffer m_buffer;
+	std::vector<sf::Vertex> m_staging;
+};
+
+#endif
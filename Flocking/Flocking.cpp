@@ -1,134 +1,97 @@
-#include <iostream>
-#include <map>
+// Usage: Flocking [--seed N] [--sdf-cache FILE] [--record FILE] [--replay FILE]
+// --seed fixes the map and the flock, the clock picks one otherwise.
+// --sdf-cache loads the obstacle distance field from FILE when it was baked for the
+// same map, and saves it there otherwise. Without it the field is baked in memory only.
+// --record writes a trace of the run to FILE.
+// --replay plays FILE back without simulating: Space pauses, Left and Right step,
+// dragging the mouse across the window scrubs through the whole trace.
 
-#include "Boid.hpp"
-#include "Obstacle.hpp"
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
 
 #include <SFML/Graphics.hpp>
 
-class Flock
+#include "Flock.hpp"
+#include "Trace.hpp"
+
+int replay(const std::string& path)
 {
-public:
-	Flock(int size, sf::RenderWindow* win, int boid_vision)
-		: m_window(win)
-		, m_cell_size(1.25f * boid_vision)
-		, m_sprites(sf::Triangles)
+	TraceReader trace;
+	if (!trace.open(path) || trace.getFrameCount() == 0)
 	{
-		std::vector<sf::FloatRect> bounds;
-		std::unique_ptr<Obstacle> ptr = std::make_unique<Circle>(100, sf::Vector2f(500, 500));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Circle>(50, sf::Vector2f(300, 700));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Circle>(70, sf::Vector2f(400, 200));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Rectangle>(sf::FloatRect(800, 100, 30, 300));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Rectangle>(sf::FloatRect(0, -50, 1000, 100));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Rectangle>(sf::FloatRect(950, 0, 100, 1000));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Rectangle>(sf::FloatRect(-50, 0, 100, 1000));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-		ptr = std::make_unique<Rectangle>(sf::FloatRect(0, 950, 1000, 100));
-		bounds.push_back(ptr->getBounds());
-		m_colliders.push_back(std::move(ptr));
-
-		for (int i = 0; i < size; i++)
-		{
-			Boid boid(800 + rand() % 300, 100 + rand() % 200, boid_vision, 130, 2.f * boid_vision, 10.f);
-			boid.setRotation(rand() % 360);
-			sf::Vector2f pos = sf::Vector2f(rand() % 1000, rand() % 1000);
-			bool reject = true;
-			while (reject)
-			{
-				pos = sf::Vector2f(rand() % 1000, rand() % 1000);
-				reject = false;
-				for (auto& i : bounds)
-					if (i.contains(pos))
-						reject = true;
-			}
-			boid.setPosition(pos);
-			m_boids.push_back(boid);
-		}
+		std::cerr << "Cannot read trace " << path << "\n";
+		return 1;
 	}
+	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
+	sf::Clock clock;
+	sf::Time elapsed = clock.restart();
+	sf::Time TPF = sf::seconds(1.f / 60);
 
-	void update(sf::Time dt)
+	// Same seed and world as the recording, so the map and the species colours match
+	Flock bao(trace.getEntityCount(), &win, 40, 0, 0, trace.getWorldSize(), trace.getSeed());
+	std::vector<TraceEntity> frame;
+	TracePlayer player(trace.getFrameCount());
+	while (win.isOpen())
 	{
-		m_map.clear();
-		for (auto& i : m_boids)
-		{
-			i.turnOff();
-			i.setThruster(true, 1.f);
-			sf::Vector2f pos = i.getPosition();
-			std::pair<int, int> coord(std::floor(pos.x / m_cell_size), std::floor(pos.y / m_cell_size));
-			m_map[coord].push_back(&i);
-		}
-
-		for (auto& i : m_boids)
+		elapsed += clock.restart();
+		sf::Event e;
+		while (win.pollEvent(e))
 		{
-			sf::Vector2f pos = i.getPosition();
-			std::pair<int, int> coord(std::floor(pos.x / m_cell_size), std::floor(pos.y / m_cell_size));
-			for (int x = coord.first - 1; x <= coord.first + 1; x++)
-				for (int y = coord.second - 1; y <= coord.second + 1; y++)
-				{
-					std::pair<int, int> cell(x, y);
-					if (m_map.find(cell) != m_map.end())
-						i.updateData(m_map[cell]);
-				}
+			if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::Escape)
+				win.close();
+			player.processEvent(e);
 		}
-
-		for (auto& i : m_boids)
+		player.scrub(win);
+		while (elapsed >= TPF)
 		{
-			i.updateFeeler(m_colliders);
-			i.update(dt);
-			sf::Vector2f pos = i.getPosition();
-			if (pos.x < 0)
-				pos.x += 1000;
-			else if (pos.x > 1000)
-				pos.x -= 1000;
-			if (pos.y < 0)
-				pos.y += 1000;
-			else if (pos.y > 1000)
-				pos.y -= 1000;
-			i.setPosition(pos);
+			elapsed -= TPF;
+			player.advance();
 		}
+		if (trace.read(player.getFrame(), frame))
+			bao.restore(frame);
+		win.clear();
+		bao.render();
+		win.display();
 	}
+	return 0;
+}
 
-	void render()
+int main(int argc, char** argv)
+{
+	std::string record_path;
+	std::string sdf_cache;
+	std::uint64_t seed = static_cast<std::uint64_t>(time(0));
+	for (int i = 1; i + 1 < argc; i += 2)
 	{
-		for (int i = 0; i < m_colliders.size(); i++)
-			m_window->draw(*m_colliders[i]);
-		m_sprites.clear();
-		for (auto& i : m_boids)
-			i.batchVertices(m_sprites);
-		m_window->draw(m_sprites);
+		std::string name = argv[i];
+		if (name == "--replay")
+			return replay(argv[i + 1]);
+		if (name == "--record")
+			record_path = argv[i + 1];
+		else if (name == "--sdf-cache")
+			sdf_cache = argv[i + 1];
+		else if (name == "--seed")
+			seed = std::strtoull(argv[i + 1], nullptr, 10);
 	}
-private:
-	sf::RenderWindow* m_window;
-	std::vector<Boid> m_boids;
-	int m_cell_size;
-	std::map<std::pair<int, int>, std::vector<Boid*>> m_map;
-	sf::VertexArray m_sprites;
-	std::vector<std::unique_ptr<Obstacle>> m_colliders;
-};
 
-int main()
-{
-	srand(time(0));
 	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
 	sf::Clock clock;
 	sf::Time elapsed = clock.restart();
 	sf::Time total = elapsed;
 	sf::Time TPF = sf::seconds(1.f / 60);
 
-	Flock bao(200, &win, 40);
+	sf::Vector2f world(1000.f, 1000.f);
+	Flock bao(200, &win, 40, 0, 0, world, seed);
+	// The whole world is on screen, so only boids without neighbours are time sliced
+	bao.setLevelOfDetail(4, win.getView().getCenter(), 1000.f);
+	bao.useDistanceField(4.f, sdf_cache);
+	bao.setAutoCellSize(true);
+	std::unique_ptr<TraceWriter> trace;
+	if (!record_path.empty())
+		trace = std::make_unique<TraceWriter>(record_path, bao.getBoidCount(), seed, world);
 	while (win.isOpen())
 	{
 		sf::Time dt = clock.restart();
@@ -144,10 +107,12 @@ int main()
 		{
 			elapsed -= TPF;
 			bao.update(TPF);
+			if (trace)
+				bao.record(*trace);
 		}
 		win.clear();
 		bao.render();
 		win.display();
 	}
 	return 0;
-}
\ No newline at end of file
+}
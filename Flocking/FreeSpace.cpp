@@ -0,0 +1,57 @@
+#include "FreeSpace.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FreeSpace::FreeSpace()
+	: m_dimension(0, 0)
+{ }
+
+void FreeSpace::build(const ObstacleSet& obstacles, sf::Vector2f world_size, int max_cells, WorkerPool& pool)
+{
+	// Square cells where possible, trimmed so a whole number of them tiles each axis
+	float side = std::sqrt(world_size.x * world_size.y / std::max(1, max_cells));
+	m_dimension.x = std::max(1, static_cast<int>(world_size.x / side));
+	m_dimension.y = std::max(1, static_cast<int>(world_size.y / side));
+	m_cell_size = sf::Vector2f(world_size.x / m_dimension.x, world_size.y / m_dimension.y);
+	float half_diagonal = 0.5f * std::sqrt(m_cell_size.x * m_cell_size.x + m_cell_size.y * m_cell_size.y);
+
+	std::vector<char> free(static_cast<std::size_t>(m_dimension.x) * m_dimension.y);
+	pool.parallelFor(m_dimension.y, 1, [&](int first, int last, int)
+		{
+			for (int y = first; y < last; y++)
+				for (int x = 0; x < m_dimension.x; x++)
+				{
+					sf::Vector2f centre((x + 0.5f) * m_cell_size.x, (y + 0.5f) * m_cell_size.y);
+					free[y * m_dimension.x + x] = obstacles.distance(centre) >= half_diagonal;
+				}
+		});
+
+	m_cells.clear();
+	for (int i = 0; i < static_cast<int>(free.size()); i++)
+		if (free[i])
+			m_cells.push_back(i);
+}
+
+bool FreeSpace::empty() const
+{
+	return m_cells.empty();
+}
+
+int FreeSpace::getCellCount() const
+{
+	return static_cast<int>(m_cells.size());
+}
+
+sf::Vector2f FreeSpace::getCellSize() const
+{
+	return m_cell_size;
+}
+
+sf::Vector2f FreeSpace::sample(Utilise::Random& random) const
+{
+	int cell = m_cells[random.below(getCellCount())];
+	return sf::Vector2f(
+		(cell % m_dimension.x + random.uniform()) * m_cell_size.x,
+		(cell / m_dimension.x + random.uniform()) * m_cell_size.y);
+}
@@ -0,0 +1,39 @@
+#ifndef AI_FLOCK_FREE_SPACE
+#define AI_FLOCK_FREE_SPACE
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "ObstacleSet.hpp"
+#include "Random.hpp"
+#include "WorkerPool.hpp"
+
+// Cells of the world that no obstacle touches. Points drawn from them never
+// need to be tested against the obstacles, whatever the map coverage.
+class FreeSpace
+{
+public:
+	FreeSpace();
+
+	// Tiles the world with at most max_cells equal cells and keeps those entirely
+	// clear of obstacles. Rows are split over pool.
+	void build(const ObstacleSet& obstacles, sf::Vector2f world_size, int max_cells, WorkerPool& pool);
+
+	// True when every cell touches an obstacle
+	bool empty() const;
+
+	int getCellCount() const;
+
+	sf::Vector2f getCellSize() const;
+
+	// Uniform point over the free cells, only reads random so it can be called from any thread
+	sf::Vector2f sample(Utilise::Random& random) const;
+private:
+	sf::Vector2f m_cell_size;
+	sf::Vector2i m_dimension;
+	// Ids y * width + x of the free cells, in increasing order
+	std::vector<int> m_cells;
+};
+
+#endif
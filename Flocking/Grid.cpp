@@ -0,0 +1,75 @@
+#include "Grid.hpp"
+
+#include <algorithm>
+
+Grid::Grid(float cell_size, sf::Vector2f world_size, int hashed_buckets, int reach)
+	: m_layout(cell_size, world_size, hashed_buckets, reach)
+	, m_cell_start(m_layout.cellCount() + 1, 0)
+	, m_cursor(m_layout.cellCount(), 0)
+{ }
+
+void Grid::rebuild(const float* x, const float* y, int count)
+{
+	m_cell_of.resize(count);
+	m_indices.resize(count);
+	std::fill(m_cell_start.begin(), m_cell_start.end(), 0);
+
+	// Count units per cell, shifted by one so the prefix sum yields start offsets
+	for (int i = 0; i < count; i++)
+	{
+		int id = m_layout.idOf(sf::Vector2f(x[i], y[i]));
+		m_cell_of[i] = id;
+		m_cell_start[id + 1]++;
+	}
+	for (int i = 1; i < static_cast<int>(m_cell_start.size()); i++)
+		m_cell_start[i] += m_cell_start[i - 1];
+
+	std::copy(m_cell_start.begin(), m_cell_start.end() - 1, m_cursor.begin());
+	for (int i = 0; i < count; i++)
+		m_indices[m_cursor[m_cell_of[i]]++] = i;
+}
+
+const CellLayout& Grid::getLayout() const
+{
+	return m_layout;
+}
+
+CellOccupancy Grid::getOccupancy() const
+{
+	CellOccupancy occupancy = { 0, 0 };
+	for (int i = 0; i + 1 < static_cast<int>(m_cell_start.size()); i++)
+	{
+		int size = m_cell_start[i + 1] - m_cell_start[i];
+		occupancy.occupied += size != 0;
+		occupancy.largest = std::max(occupancy.largest, size);
+	}
+	return occupancy;
+}
+
+Grid::Range Grid::cell(int x, int y) const
+{
+	sf::Vector2i dimension = m_layout.getDimension();
+	if (x < 0 || y < 0 || x >= dimension.x || y >= dimension.y || m_indices.empty())
+		return Range{ nullptr, nullptr };
+	int id = m_layout.idOfCell(x, y);
+	const int* data = m_indices.data();
+	return Range{ data + m_cell_start[id], data + m_cell_start[id + 1] };
+}
+
+void Grid::gatherRing(sf::Vector2f position, int ring, std::vector<int>& out) const
+{
+	out.clear();
+	m_layout.forEachRingId(position, ring, [&](int id)
+		{
+			out.insert(out.end(), m_indices.data() + m_cell_start[id], m_indices.data() + m_cell_start[id + 1]);
+		});
+}
+
+void Grid::gather(sf::Vector2f position, std::vector<int>& out) const
+{
+	out.clear();
+	forEachNeighbourCell(position, [&](Range range)
+		{
+			out.insert(out.end(), range.first, range.last);
+		});
+}
@@ -0,0 +1,63 @@
+#ifndef AI_FLOCK_GRID
+#define AI_FLOCK_GRID
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "CellLayout.hpp"
+
+// Uniform grid over a periodic world, rebuilt every tick with a counting sort.
+// Indices of units inside one cell are stored contiguously in m_indices,
+// from m_cell_start[cell] to m_cell_start[cell + 1].
+class Grid
+{
+public:
+	struct Range
+	{
+		const int* first;
+		const int* last;
+	};
+public:
+	// See CellLayout
+	Grid(float cell_size, sf::Vector2f world_size, int hashed_buckets = 0, int reach = 1);
+
+	void rebuild(const float* x, const float* y, int count);
+
+	const CellLayout& getLayout() const;
+
+	// Scans every cell, meant for periodic statistics
+	CellOccupancy getOccupancy() const;
+
+	// Empty range if the cell is outside the grid.
+	// With a hashed layout the range holds every unit of the cell's bucket.
+	Range cell(int x, int y) const;
+
+	// Calls func(range) for every non-empty cell within reach of position
+	template<typename Func>
+	void forEachNeighbourCell(sf::Vector2f position, Func func) const
+	{
+		m_layout.forEachNeighbourId(position, [&](int id)
+			{
+				int begin = m_cell_start[id], end = m_cell_start[id + 1];
+				if (begin != end)
+					func(Range{ m_indices.data() + begin, m_indices.data() + end });
+			});
+	}
+
+	// Replaces the content of out with the indices of the cells exactly ring steps from the
+	// cell of position. Needs CellLayout::hasRings.
+	void gatherRing(sf::Vector2f position, int ring, std::vector<int>& out) const;
+
+	// Replaces the content of out with the indices of the cells within reach of position.
+	// Reusing out between calls keeps the query allocation-free.
+	void gather(sf::Vector2f position, std::vector<int>& out) const;
+private:
+	CellLayout m_layout;
+	std::vector<int> m_cell_start;
+	std::vector<int> m_cursor;
+	std::vector<int> m_cell_of;
+	std::vector<int> m_indices;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "IncrementalGrid.hpp"
+
+#include <algorithm>
+
+IncrementalGrid::IncrementalGrid(float cell_size, sf::Vector2f world_size, int hashed_buckets, int reach)
+	: m_layout(cell_size, world_size, hashed_buckets, reach)
+	, m_buckets(m_layout.cellCount())
+	, m_migrations(0)
+{ }
+
+void IncrementalGrid::update(const float* x, const float* y, int count)
+{
+	if (count != static_cast<int>(m_cell_of.size()))
+	{
+		for (auto& i : m_buckets)
+			i.clear();
+		m_cell_of.resize(count);
+		m_slot_of.resize(count);
+		for (int i = 0; i < count; i++)
+			insert(i, m_layout.idOf(sf::Vector2f(x[i], y[i])));
+		m_migrations = count;
+		return;
+	}
+
+	m_migrations = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int cell = m_layout.idOf(sf::Vector2f(x[i], y[i]));
+		if (cell == m_cell_of[i])
+			continue;
+		remove(i);
+		insert(i, cell);
+		m_migrations++;
+	}
+}
+
+void IncrementalGrid::clear()
+{
+	for (auto& i : m_buckets)
+		i.clear();
+	m_cell_of.clear();
+	m_slot_of.clear();
+	m_migrations = 0;
+}
+
+const CellLayout& IncrementalGrid::getLayout() const
+{
+	return m_layout;
+}
+
+int IncrementalGrid::getMigrationCount() const
+{
+	return m_migrations;
+}
+
+CellOccupancy IncrementalGrid::getOccupancy() const
+{
+	CellOccupancy occupancy = { 0, 0 };
+	for (auto& i : m_buckets)
+	{
+		int size = static_cast<int>(i.size());
+		occupancy.occupied += size != 0;
+		occupancy.largest = std::max(occupancy.largest, size);
+	}
+	return occupancy;
+}
+
+void IncrementalGrid::gatherRing(sf::Vector2f position, int ring, std::vector<int>& out) const
+{
+	out.clear();
+	m_layout.forEachRingId(position, ring, [&](int id)
+		{
+			const std::vector<int>& bucket = m_buckets[id];
+			out.insert(out.end(), bucket.begin(), bucket.end());
+		});
+}
+
+void IncrementalGrid::gather(sf::Vector2f position, std::vector<int>& out) const
+{
+	out.clear();
+	m_layout.forEachNeighbourId(position, [&](int id)
+		{
+			const std::vector<int>& bucket = m_buckets[id];
+			out.insert(out.end(), bucket.begin(), bucket.end());
+		});
+}
+
+void IncrementalGrid::insert(int id, int cell)
+{
+	std::vector<int>& bucket = m_buckets[cell];
+	m_cell_of[id] = cell;
+	m_slot_of[id] = static_cast<int>(bucket.size());
+	bucket.push_back(id);
+}
+
+void IncrementalGrid::remove(int id)
+{
+	// The last unit of the bucket takes the freed slot
+	std::vector<int>& bucket = m_buckets[m_cell_of[id]];
+	int moved = bucket.back();
+	bucket[m_slot_of[id]] = moved;
+	m_slot_of[moved] = m_slot_of[id];
+	bucket.pop_back();
+}
@@ -0,0 +1,52 @@
+#ifndef AI_FLOCK_INCREMENTAL_GRID
+#define AI_FLOCK_INCREMENTAL_GRID
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "CellLayout.hpp"
+
+// Uniform grid over a periodic world that is updated in place.
+// Every unit remembers its cell and its slot in the cell's bucket, so only units
+// that crossed into another cell since the last update are moved, each in O(1).
+// Buckets keep their capacity, a settled flock updates without allocating.
+class IncrementalGrid
+{
+public:
+	// See CellLayout
+	IncrementalGrid(float cell_size, sf::Vector2f world_size, int hashed_buckets = 0, int reach = 1);
+
+	// Everything is inserted again when count differs from the last update
+	void update(const float* x, const float* y, int count);
+
+	// The next update inserts everything again
+	void clear();
+
+	const CellLayout& getLayout() const;
+
+	// Units that changed cell in the last update
+	int getMigrationCount() const;
+
+	// Scans every cell, meant for periodic statistics
+	CellOccupancy getOccupancy() const;
+
+	// See Grid::gatherRing
+	void gatherRing(sf::Vector2f position, int ring, std::vector<int>& out) const;
+
+	// Replaces the content of out with the indices of the cells within reach of position.
+	// Reusing out between calls keeps the query allocation-free.
+	void gather(sf::Vector2f position, std::vector<int>& out) const;
+private:
+	void insert(int id, int cell);
+
+	void remove(int id);
+private:
+	CellLayout m_layout;
+	std::vector<std::vector<int>> m_buckets;
+	std::vector<int> m_cell_of;
+	std::vector<int> m_slot_of;
+	int m_migrations;
+};
+
+#endif
@@ -5,23 +5,20 @@
 
 #include <SFML/Graphics.hpp>
 
+// Drawable side of an obstacle, ray queries go through ObstacleSet
 class Obstacle : public sf::Drawable
 {
 public:
 	Obstacle();
 	virtual ~Obstacle() = default;
 
-	virtual float checkRay(sf::Vector2f start, sf::Vector2f end, bool& collide) const = 0;
-
 	virtual sf::FloatRect getBounds() const = 0;
 };
 
 class Rectangle : public Obstacle
 {
 public:
-	Rectangle(sf::FloatRect bound);
-
-	float checkRay(sf::Vector2f start, sf::Vector2f end, bool& collide) const override;
+	Rectangle(sf::FloatRect bound, sf::Color color);
 
 	sf::FloatRect getBounds() const override;
 private:
@@ -33,9 +30,7 @@ private:
 class Circle : public Obstacle
 {
 public:
-	Circle(float radius, sf::Vector2f position);
-
-	float checkRay(sf::Vector2f start, sf::Vector2f end, bool& collide) const override;
+	Circle(float radius, sf::Vector2f position, sf::Color color);
 
 	sf::FloatRect getBounds() const override;
 private:
@@ -0,0 +1,258 @@
+#include "ObstacleSet.hpp"
+#include "Simd.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	const float INF = std::numeric_limits<float>::infinity();
+
+	float inverse(float value)
+	{
+		return value == 0.f ? 1e30f : 1.f / value;
+	}
+
+#if defined(AI_SIMD_AVX2)
+	float horizontalMin(__m256 v)
+	{
+		__m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+		return _mm_cvtss_f32(m);
+	}
+
+	__m256 select(__m256 mask, __m256 a, __m256 b)
+	{
+		return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+	}
+#elif defined(AI_SIMD_SSE2)
+	float horizontalMin(__m128 v)
+	{
+		__m128 m = _mm_min_ps(v, _mm_movehl_ps(v, v));
+		m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+		return _mm_cvtss_f32(m);
+	}
+
+	__m128 select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+#endif
+}
+
+Ray::Ray(sf::Vector2f start, sf::Vector2f end)
+	: start(start)
+	, dir(end - start)
+	, inv_dir(inverse(dir.x), inverse(dir.y))
+	, length_squared(dir.x * dir.x + dir.y * dir.y)
+{ }
+
+void ObstacleSet::addCircle(sf::Vector2f centre, float radius)
+{
+	m_circle_x.push_back(centre.x);
+	m_circle_y.push_back(centre.y);
+	m_circle_radius.push_back(radius);
+}
+
+void ObstacleSet::addBox(sf::FloatRect bounds)
+{
+	m_box_min_x.push_back(bounds.left);
+	m_box_min_y.push_back(bounds.top);
+	m_box_max_x.push_back(bounds.left + bounds.width);
+	m_box_max_y.push_back(bounds.top + bounds.height);
+}
+
+void ObstacleSet::clear()
+{
+	m_circle_x.clear();
+	m_circle_y.clear();
+	m_circle_radius.clear();
+	m_box_min_x.clear();
+	m_box_min_y.clear();
+	m_box_max_x.clear();
+	m_box_max_y.clear();
+}
+
+int ObstacleSet::circleCount() const
+{
+	return static_cast<int>(m_circle_x.size());
+}
+
+int ObstacleSet::boxCount() const
+{
+	return static_cast<int>(m_box_min_x.size());
+}
+
+sf::FloatRect ObstacleSet::circleBounds(int id) const
+{
+	float r = m_circle_radius[id];
+	return sf::FloatRect(m_circle_x[id] - r, m_circle_y[id] - r, 2.f * r, 2.f * r);
+}
+
+sf::FloatRect ObstacleSet::boxBounds(int id) const
+{
+	return sf::FloatRect(m_box_min_x[id], m_box_min_y[id],
+		m_box_max_x[id] - m_box_min_x[id], m_box_max_y[id] - m_box_min_y[id]);
+}
+
+float ObstacleSet::distance(sf::Vector2f point) const
+{
+	float best = INF;
+	for (int i = 0; i < circleCount(); i++)
+	{
+		float dx = point.x - m_circle_x[i], dy = point.y - m_circle_y[i];
+		best = std::min(best, std::sqrt(dx * dx + dy * dy) - m_circle_radius[i]);
+	}
+	for (int i = 0; i < boxCount(); i++)
+	{
+		// Offset from the box surface along each axis, negative inside
+		float half_x = 0.5f * (m_box_max_x[i] - m_box_min_x[i]);
+		float half_y = 0.5f * (m_box_max_y[i] - m_box_min_y[i]);
+		float qx = std::abs(point.x - (m_box_min_x[i] + half_x)) - half_x;
+		float qy = std::abs(point.y - (m_box_min_y[i] + half_y)) - half_y;
+		float ox = std::max(qx, 0.f), oy = std::max(qy, 0.f);
+		best = std::min(best, std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.f));
+	}
+	return best;
+}
+
+bool ObstacleSet::raycastCircles(const Ray& ray, int first, int last, float& time) const
+{
+	if (ray.length_squared == 0.f)
+		return false;
+	float best = INF;
+	float inv_length = 1.f / ray.length_squared;
+	int i = first;
+#if defined(AI_SIMD_AVX2)
+	if (last - i >= 8)
+	{
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), inf = _mm256_set1_ps(INF);
+		const __m256 sx = _mm256_set1_ps(ray.start.x), sy = _mm256_set1_ps(ray.start.y);
+		const __m256 dx = _mm256_set1_ps(ray.dir.x), dy = _mm256_set1_ps(ray.dir.y);
+		const __m256 len = _mm256_set1_ps(ray.length_squared), inv_len = _mm256_set1_ps(inv_length);
+		__m256 nearest = inf;
+		for (; last - i >= 8; i += 8)
+		{
+			__m256 ox = _mm256_sub_ps(_mm256_loadu_ps(m_circle_x.data() + i), sx);
+			__m256 oy = _mm256_sub_ps(_mm256_loadu_ps(m_circle_y.data() + i), sy);
+			__m256 r = _mm256_loadu_ps(m_circle_radius.data() + i);
+			__m256 proj = _mm256_add_ps(_mm256_mul_ps(ox, dx), _mm256_mul_ps(oy, dy));
+			__m256 outside = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(r, r));
+			__m256 disc = _mm256_sub_ps(_mm256_mul_ps(proj, proj), _mm256_mul_ps(len, outside));
+			__m256 t = _mm256_mul_ps(_mm256_sub_ps(proj, _mm256_sqrt_ps(_mm256_max_ps(disc, zero))), inv_len);
+			__m256 hit = _mm256_and_ps(_mm256_and_ps(
+				_mm256_cmp_ps(proj, zero, _CMP_GE_OQ),
+				_mm256_cmp_ps(disc, zero, _CMP_GT_OQ)),
+				_mm256_cmp_ps(t, one, _CMP_LE_OQ));
+			nearest = _mm256_min_ps(nearest, select(hit, t, inf));
+		}
+		best = horizontalMin(nearest);
+	}
+#elif defined(AI_SIMD_SSE2)
+	if (last - i >= 4)
+	{
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), inf = _mm_set1_ps(INF);
+		const __m128 sx = _mm_set1_ps(ray.start.x), sy = _mm_set1_ps(ray.start.y);
+		const __m128 dx = _mm_set1_ps(ray.dir.x), dy = _mm_set1_ps(ray.dir.y);
+		const __m128 len = _mm_set1_ps(ray.length_squared), inv_len = _mm_set1_ps(inv_length);
+		__m128 nearest = inf;
+		for (; last - i >= 4; i += 4)
+		{
+			__m128 ox = _mm_sub_ps(_mm_loadu_ps(m_circle_x.data() + i), sx);
+			__m128 oy = _mm_sub_ps(_mm_loadu_ps(m_circle_y.data() + i), sy);
+			__m128 r = _mm_loadu_ps(m_circle_radius.data() + i);
+			__m128 proj = _mm_add_ps(_mm_mul_ps(ox, dx), _mm_mul_ps(oy, dy));
+			__m128 outside = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(r, r));
+			__m128 disc = _mm_sub_ps(_mm_mul_ps(proj, proj), _mm_mul_ps(len, outside));
+			__m128 t = _mm_mul_ps(_mm_sub_ps(proj, _mm_sqrt_ps(_mm_max_ps(disc, zero))), inv_len);
+			__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(proj, zero), _mm_cmpgt_ps(disc, zero)), _mm_cmple_ps(t, one));
+			nearest = _mm_min_ps(nearest, select(hit, t, inf));
+		}
+		best = horizontalMin(nearest);
+	}
+#endif
+	for (; i < last; i++)
+	{
+		float ox = m_circle_x[i] - ray.start.x, oy = m_circle_y[i] - ray.start.y, r = m_circle_radius[i];
+		float proj = ox * ray.dir.x + oy * ray.dir.y;
+		float disc = proj * proj - ray.length_squared * (ox * ox + oy * oy - r * r);
+		if (proj < 0.f || disc <= 0.f)
+			continue;
+		float t = (proj - std::sqrt(disc)) * inv_length;
+		if (t <= 1.f)
+			best = std::min(best, t);
+	}
+	if (best < time)
+	{
+		time = best;
+		return true;
+	}
+	return false;
+}
+
+bool ObstacleSet::raycastBoxes(const Ray& ray, int first, int last, float& time) const
+{
+	float best = INF;
+	int i = first;
+#if defined(AI_SIMD_AVX2)
+	if (last - i >= 8)
+	{
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), inf = _mm256_set1_ps(INF);
+		const __m256 sx = _mm256_set1_ps(ray.start.x), sy = _mm256_set1_ps(ray.start.y);
+		const __m256 ix = _mm256_set1_ps(ray.inv_dir.x), iy = _mm256_set1_ps(ray.inv_dir.y);
+		__m256 nearest = inf;
+		for (; last - i >= 8; i += 8)
+		{
+			__m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(m_box_min_x.data() + i), sx), ix);
+			__m256 t2x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(m_box_max_x.data() + i), sx), ix);
+			__m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(m_box_min_y.data() + i), sy), iy);
+			__m256 t2y = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(m_box_max_y.data() + i), sy), iy);
+			__m256 entry = _mm256_max_ps(_mm256_min_ps(t1x, t2x), _mm256_min_ps(t1y, t2y));
+			__m256 exit = _mm256_min_ps(_mm256_max_ps(t1x, t2x), _mm256_max_ps(t1y, t2y));
+			__m256 hit = _mm256_and_ps(_mm256_and_ps(
+				_mm256_cmp_ps(entry, exit, _CMP_LE_OQ),
+				_mm256_cmp_ps(exit, zero, _CMP_GE_OQ)),
+				_mm256_cmp_ps(entry, one, _CMP_LE_OQ));
+			nearest = _mm256_min_ps(nearest, select(hit, entry, inf));
+		}
+		best = horizontalMin(nearest);
+	}
+#elif defined(AI_SIMD_SSE2)
+	if (last - i >= 4)
+	{
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), inf = _mm_set1_ps(INF);
+		const __m128 sx = _mm_set1_ps(ray.start.x), sy = _mm_set1_ps(ray.start.y);
+		const __m128 ix = _mm_set1_ps(ray.inv_dir.x), iy = _mm_set1_ps(ray.inv_dir.y);
+		__m128 nearest = inf;
+		for (; last - i >= 4; i += 4)
+		{
+			__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(m_box_min_x.data() + i), sx), ix);
+			__m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(m_box_max_x.data() + i), sx), ix);
+			__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(m_box_min_y.data() + i), sy), iy);
+			__m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(m_box_max_y.data() + i), sy), iy);
+			__m128 entry = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+			__m128 exit = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+			__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(entry, exit), _mm_cmpge_ps(exit, zero)), _mm_cmple_ps(entry, one));
+			nearest = _mm_min_ps(nearest, select(hit, entry, inf));
+		}
+		best = horizontalMin(nearest);
+	}
+#endif
+	for (; i < last; i++)
+	{
+		float t1x = (m_box_min_x[i] - ray.start.x) * ray.inv_dir.x, t2x = (m_box_max_x[i] - ray.start.x) * ray.inv_dir.x;
+		float t1y = (m_box_min_y[i] - ray.start.y) * ray.inv_dir.y, t2y = (m_box_max_y[i] - ray.start.y) * ray.inv_dir.y;
+		float entry = std::max(std::min(t1x, t2x), std::min(t1y, t2y));
+		float exit = std::min(std::max(t1x, t2x), std::max(t1y, t2y));
+		if (entry <= exit && exit >= 0.f && entry <= 1.f)
+			best = std::min(best, entry);
+	}
+	if (best < time)
+	{
+		time = best;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,61 @@
+#ifndef AI_FLOCK_OBSTACLE_SET
+#define AI_FLOCK_OBSTACLE_SET
+
+#include <SFML/Graphics.hpp>
+
+#include "AlignedArray.hpp"
+
+// Segment from start to start + dir, with the values every ray test needs
+struct Ray
+{
+	Ray(sf::Vector2f start, sf::Vector2f end);
+
+	sf::Vector2f start;
+	sf::Vector2f dir;
+	// 1 / dir, axes with no movement get a huge finite value instead of inf
+	sf::Vector2f inv_dir;
+	float length_squared;
+};
+
+// Raw obstacle geometry, one packed array per field and per shape type,
+// so a ray can be tested against several shapes per instruction.
+// The SFML shapes in Obstacle.hpp are only used for drawing.
+class ObstacleSet
+{
+public:
+	void addCircle(sf::Vector2f centre, float radius);
+
+	void addBox(sf::FloatRect bounds);
+
+	void clear();
+
+	int circleCount() const;
+
+	int boxCount() const;
+
+	sf::FloatRect circleBounds(int id) const;
+
+	sf::FloatRect boxBounds(int id) const;
+
+	// Signed distance from point to the nearest shape, negative inside one.
+	// Infinite when the set is empty.
+	float distance(sf::Vector2f point) const;
+
+	// Nearest hit against circles [first, last), as a fraction of the ray length.
+	// time is only written on a hit earlier than its current value.
+	bool raycastCircles(const Ray& ray, int first, int last, float& time) const;
+
+	// Same as raycastCircles but against boxes [first, last).
+	// Starting inside a box gives a negative time.
+	bool raycastBoxes(const Ray& ray, int first, int last, float& time) const;
+private:
+	AlignedArray<float> m_circle_x;
+	AlignedArray<float> m_circle_y;
+	AlignedArray<float> m_circle_radius;
+	AlignedArray<float> m_box_min_x;
+	AlignedArray<float> m_box_min_y;
+	AlignedArray<float> m_box_max_x;
+	AlignedArray<float> m_box_max_y;
+};
+
+#endif
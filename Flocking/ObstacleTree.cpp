@@ -0,0 +1,175 @@
+#include "ObstacleTree.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	// Entry of the ray into the box, if it gets there between 0 and 1
+	bool clipRay(const Ray& ray, sf::Vector2f min, sf::Vector2f max, float& entry)
+	{
+		float t1x = (min.x - ray.start.x) * ray.inv_dir.x, t2x = (max.x - ray.start.x) * ray.inv_dir.x;
+		float t1y = (min.y - ray.start.y) * ray.inv_dir.y, t2y = (max.y - ray.start.y) * ray.inv_dir.y;
+		float t_min = std::max(0.f, std::max(std::min(t1x, t2x), std::min(t1y, t2y)));
+		float t_max = std::min(1.f, std::min(std::max(t1x, t2x), std::max(t1y, t2y)));
+		entry = t_min;
+		return t_min <= t_max;
+	}
+}
+
+void ObstacleTree::build(const ObstacleSet& obstacles)
+{
+	m_items.clear();
+	m_nodes.clear();
+	m_packed.clear();
+	for (int i = 0; i < obstacles.circleCount(); i++)
+	{
+		sf::FloatRect bounds = obstacles.circleBounds(i);
+		m_items.push_back(Item{
+			sf::Vector2f(bounds.left, bounds.top),
+			sf::Vector2f(bounds.left + bounds.width, bounds.top + bounds.height),
+			bounds, true });
+	}
+	for (int i = 0; i < obstacles.boxCount(); i++)
+	{
+		sf::FloatRect bounds = obstacles.boxBounds(i);
+		m_items.push_back(Item{
+			sf::Vector2f(bounds.left, bounds.top),
+			sf::Vector2f(bounds.left + bounds.width, bounds.top + bounds.height),
+			bounds, false });
+	}
+	if (!m_items.empty())
+	{
+		m_nodes.reserve(2 * m_items.size());
+		buildNode(0, static_cast<int>(m_items.size()));
+	}
+}
+
+int ObstacleTree::buildNode(int first, int last)
+{
+	int id = static_cast<int>(m_nodes.size());
+	m_nodes.push_back(Node());
+	Node node;
+	node.min = m_items[first].min;
+	node.max = m_items[first].max;
+	sf::Vector2f centre_min = (node.min + node.max) / 2.f, centre_max = centre_min;
+	for (int i = first; i < last; i++)
+	{
+		const Item& item = m_items[i];
+		node.min = sf::Vector2f(std::min(node.min.x, item.min.x), std::min(node.min.y, item.min.y));
+		node.max = sf::Vector2f(std::max(node.max.x, item.max.x), std::max(node.max.y, item.max.y));
+		sf::Vector2f centre = (item.min + item.max) / 2.f;
+		centre_min = sf::Vector2f(std::min(centre_min.x, centre.x), std::min(centre_min.y, centre.y));
+		centre_max = sf::Vector2f(std::max(centre_max.x, centre.x), std::max(centre_max.y, centre.y));
+	}
+
+	if (last - first <= LEAF_SIZE)
+	{
+		// Leaves are created in depth-first order, so their shapes end up contiguous
+		node.right = -1;
+		node.circle_first = m_packed.circleCount();
+		node.box_first = m_packed.boxCount();
+		for (int i = first; i < last; i++)
+		{
+			const sf::FloatRect& shape = m_items[i].shape;
+			if (m_items[i].circle)
+				m_packed.addCircle(sf::Vector2f(shape.left + shape.width / 2.f, shape.top + shape.height / 2.f), shape.width / 2.f);
+			else
+				m_packed.addBox(shape);
+		}
+		node.circle_last = m_packed.circleCount();
+		node.box_last = m_packed.boxCount();
+		m_nodes[id] = node;
+		return id;
+	}
+
+	// Median split along the axis where the centres spread the most
+	bool split_x = centre_max.x - centre_min.x >= centre_max.y - centre_min.y;
+	int middle = (first + last) / 2;
+	std::nth_element(m_items.begin() + first, m_items.begin() + middle, m_items.begin() + last,
+		[split_x](const Item& a, const Item& b)
+		{
+			return split_x ? a.min.x + a.max.x < b.min.x + b.max.x : a.min.y + a.max.y < b.min.y + b.max.y;
+		});
+	buildNode(first, middle);
+	node.right = buildNode(middle, last);
+	m_nodes[id] = node;
+	return id;
+}
+
+bool ObstacleTree::raycast(sf::Vector2f start, sf::Vector2f end, float& time) const
+{
+	if (m_nodes.empty())
+		return false;
+	Ray ray(start, end);
+	bool hit = false;
+	float best = std::numeric_limits<float>::infinity();
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		int id = stack[--top];
+		const Node& node = m_nodes[id];
+		float entry;
+		// Hits inside a box come back negative, so never prune below 0
+		if (!clipRay(ray, node.min, node.max, entry) || entry > std::max(best, 0.f))
+			continue;
+		if (node.right < 0)
+		{
+			hit |= m_packed.raycastCircles(ray, node.circle_first, node.circle_last, best);
+			hit |= m_packed.raycastBoxes(ray, node.box_first, node.box_last, best);
+		}
+		else
+		{
+			stack[top++] = node.right;
+			stack[top++] = id + 1;
+		}
+	}
+	if (hit)
+		time = best;
+	return hit;
+}
+
+void ObstacleTree::gather(sf::Vector2f min, sf::Vector2f max, ObstacleSet& out) const
+{
+	if (m_nodes.empty())
+		return;
+	auto overlaps = [&](sf::FloatRect bounds)
+	{
+		return bounds.left <= max.x && bounds.left + bounds.width >= min.x
+			&& bounds.top <= max.y && bounds.top + bounds.height >= min.y;
+	};
+
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top)
+	{
+		int id = stack[--top];
+		const Node& node = m_nodes[id];
+		if (node.min.x > max.x || node.max.x < min.x || node.min.y > max.y || node.max.y < min.y)
+			continue;
+		if (node.right < 0)
+		{
+			for (int i = node.circle_first; i < node.circle_last; i++)
+			{
+				sf::FloatRect bounds = m_packed.circleBounds(i);
+				if (overlaps(bounds))
+					out.addCircle(sf::Vector2f(bounds.left + bounds.width / 2.f, bounds.top + bounds.height / 2.f), bounds.width / 2.f);
+			}
+			for (int i = node.box_first; i < node.box_last; i++)
+			{
+				sf::FloatRect bounds = m_packed.boxBounds(i);
+				if (overlaps(bounds))
+					out.addBox(bounds);
+			}
+		}
+		else
+		{
+			stack[top++] = node.right;
+			stack[top++] = id + 1;
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef AI_FLOCK_OBSTACLE_TREE
+#define AI_FLOCK_OBSTACLE_TREE
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "ObstacleSet.hpp"
+
+// Static bounding volume hierarchy over the shapes of an ObstacleSet.
+// Keeps its own copy of the geometry, reordered so every leaf owns
+// a contiguous run of circles and a contiguous run of boxes.
+// Must be rebuilt whenever the obstacles change.
+class ObstacleTree
+{
+public:
+	void build(const ObstacleSet& obstacles);
+
+	// Nearest hit along the segment from start to end, as a fraction of its length.
+	// Returns false if nothing is hit.
+	bool raycast(sf::Vector2f start, sf::Vector2f end, float& time) const;
+
+	// Appends to out every shape whose bounds overlap the box from min to max
+	void gather(sf::Vector2f min, sf::Vector2f max, ObstacleSet& out) const;
+private:
+	struct Node
+	{
+		sf::Vector2f min;
+		sf::Vector2f max;
+		// Index of the right child, the left child follows the node directly.
+		// -1 for leaves.
+		int right;
+		int circle_first;
+		int circle_last;
+		int box_first;
+		int box_last;
+	};
+
+	struct Item
+	{
+		sf::Vector2f min;
+		sf::Vector2f max;
+		sf::FloatRect shape;
+		bool circle;
+	};
+private:
+	int buildNode(int first, int last);
+private:
+	static const int LEAF_SIZE = 8;
+	std::vector<Node> m_nodes;
+	std::vector<Item> m_items;
+	ObstacleSet m_packed;
+};
+
+#endif
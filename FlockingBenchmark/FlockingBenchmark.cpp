@@ -0,0 +1,234 @@
+// Headless benchmark of Flock::update, prints one JSON object to stdout
+// Usage: FlockingBenchmark [--seed N] [--boids N] [--obstacles N] [--vision N]
+//                          [--ticks N] [--warmup N] [--threads N]
+//                          [--lod N] [--lod-radius N] [--world N] [--sdf N]
+//                          [--incremental 0|1] [--chunk N] [--active-radius N]
+//                          [--cell N] [--auto-cell 0|1] [--nearest N] [--reorder N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <sys/resource.h>
+#endif
+
+#include <SFML/Graphics.hpp>
+
+#include "Flock.hpp"
+
+struct Options
+{
+	unsigned int seed = 1;
+	int boids = 10000;
+	int obstacles = 0;
+	int vision = 40;
+	int ticks = 600;
+	int warmup = 60;
+	int threads = 0;
+	// Level of detail interval, and the radius around the world centre kept at full detail
+	int lod = 1;
+	int lod_radius = 0;
+	// Side of the square periodic world
+	int world = 1000;
+	// Texel size of the obstacle distance field, 0 casts rays against the obstacle tree
+	int sdf = 0;
+	// 1 moves only the boids that changed cell, 0 rebuilds the grid every tick
+	int incremental = 1;
+	// Paging: chunk size, and the radius around the world centre that is simulated. 0 disables it.
+	int chunk = 0;
+	int active_radius = 0;
+	// Neighbour grid cell size, 0 keeps the default, and 1 lets the flock tune it
+	int cell = 0;
+	int auto_cell = 0;
+	// Topological mode, steer from the N nearest visible neighbours. 0 uses all of them.
+	int nearest = 0;
+	// Ticks between Morton reorderings of the boid storage, 0 never reorders
+	int reorder = 60;
+};
+
+bool parse(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+			return false;
+		std::string name = argv[i];
+		int value = std::atoi(argv[++i]);
+		if (name == "--seed")
+			options.seed = static_cast<unsigned int>(value);
+		else if (name == "--boids")
+			options.boids = value;
+		else if (name == "--obstacles")
+			options.obstacles = value;
+		else if (name == "--vision")
+			options.vision = value;
+		else if (name == "--ticks")
+			options.ticks = value;
+		else if (name == "--warmup")
+			options.warmup = value;
+		else if (name == "--threads")
+			options.threads = value;
+		else if (name == "--lod")
+			options.lod = value;
+		else if (name == "--lod-radius")
+			options.lod_radius = value;
+		else if (name == "--world")
+			options.world = value;
+		else if (name == "--sdf")
+			options.sdf = value;
+		else if (name == "--incremental")
+			options.incremental = value;
+		else if (name == "--chunk")
+			options.chunk = value;
+		else if (name == "--active-radius")
+			options.active_radius = value;
+		else if (name == "--cell")
+			options.cell = value;
+		else if (name == "--auto-cell")
+			options.auto_cell = value;
+		else if (name == "--nearest")
+			options.nearest = value;
+		else if (name == "--reorder")
+			options.reorder = value;
+		else
+			return false;
+	}
+	return options.boids > 0 && options.boids <= SlotMap::MAX_SLOTS && options.vision > 0 && options.ticks > 0 && options.warmup >= 0
+		&& options.lod > 0 && options.lod_radius >= 0 && options.world > 0 && options.sdf >= 0
+		&& options.chunk >= 0 && options.active_radius >= 0 && options.cell >= 0
+		&& options.nearest >= 0 && options.reorder >= 0;
+}
+
+// Peak resident memory of the process, in bytes
+long long peakMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return static_cast<long long>(counters.PeakWorkingSetSize);
+	return -1;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+	#if defined(__APPLE__)
+		return usage.ru_maxrss;
+	#else
+		return usage.ru_maxrss * 1024LL;
+	#endif
+#endif
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+	int id = static_cast<int>(p * (sorted.size() - 1) + 0.5);
+	return sorted[id];
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parse(argc, argv, options))
+	{
+		std::cerr << "Usage: " << argv[0] << " [--seed N] [--boids N] [--obstacles N] [--vision N]"
+			" [--ticks N] [--warmup N] [--threads N] [--lod N] [--lod-radius N] [--world N] [--sdf N] [--incremental 0|1]"
+			" [--chunk N] [--active-radius N] [--cell N] [--auto-cell 0|1] [--nearest N] [--reorder N]\n"
+			"--boids is at most " << SlotMap::MAX_SLOTS << ".\n";
+		return 1;
+	}
+
+	typedef std::chrono::steady_clock Clock;
+	const sf::Time TPF = sf::seconds(1.f / 60);
+
+	Clock::time_point start = Clock::now();
+	sf::Vector2f world(static_cast<float>(options.world), static_cast<float>(options.world));
+	Flock flock(options.boids, nullptr, options.vision, options.threads, options.obstacles, world, options.seed);
+	double setup_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	flock.setIndexMode(options.incremental ? Flock::INCREMENTAL : Flock::REBUILD);
+	flock.setNearestCount(options.nearest);
+	if (options.cell > 0)
+		flock.setCellSize(static_cast<float>(options.cell));
+	flock.setAutoCellSize(options.auto_cell != 0);
+	flock.setReorderInterval(options.reorder);
+	if (options.chunk > 0)
+		flock.setActiveRegion(0.5f * world, static_cast<float>(options.active_radius), static_cast<float>(options.chunk));
+	start = Clock::now();
+	if (options.sdf > 0)
+		flock.useDistanceField(static_cast<float>(options.sdf));
+	double sdf_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	flock.setLevelOfDetail(options.lod, 0.5f * world, static_cast<float>(options.lod_radius));
+
+	for (int i = 0; i < options.warmup; i++)
+		flock.update(TPF);
+
+	std::vector<double> ticks(options.ticks);
+	long long migrations = 0;
+	// Boid ticks actually simulated, boids may be parked when paging
+	long long active = 0;
+	for (int i = 0; i < options.ticks; i++)
+	{
+		active += flock.getBoidCount();
+		Clock::time_point begin = Clock::now();
+		flock.update(TPF);
+		ticks[i] = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+		migrations += flock.getMigrationCount();
+	}
+
+	double total = 0.0;
+	for (double i : ticks)
+		total += i;
+	std::vector<double> sorted(ticks);
+	std::sort(sorted.begin(), sorted.end());
+	const double NS_PER_MS = 1e6;
+	const Flock::GridStats& stats = flock.getGridStats();
+
+	std::cout << "{\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"boids\": " << options.boids << ",\n"
+		<< "  \"obstacles\": " << options.obstacles << ",\n"
+		<< "  \"vision\": " << options.vision << ",\n"
+		<< "  \"ticks\": " << options.ticks << ",\n"
+		<< "  \"warmup\": " << options.warmup << ",\n"
+		<< "  \"threads\": " << flock.getThreadCount() << ",\n"
+		<< "  \"world\": " << options.world << ",\n"
+		<< "  \"lod\": " << options.lod << ",\n"
+		<< "  \"lod_radius\": " << options.lod_radius << ",\n"
+		<< "  \"sdf\": " << options.sdf << ",\n"
+		<< "  \"incremental\": " << options.incremental << ",\n"
+		<< "  \"setup_ms\": " << setup_ms << ",\n"
+		<< "  \"sdf_ms\": " << sdf_ms << ",\n"
+		<< "  \"chunk\": " << options.chunk << ",\n"
+		<< "  \"active_radius\": " << options.active_radius << ",\n"
+		<< "  \"active_boids\": " << flock.getBoidCount() << ",\n"
+		<< "  \"parked_boids\": " << flock.getParkedCount() << ",\n"
+		<< "  \"chunks\": " << flock.getChunkCount() << ",\n"
+		<< "  \"nearest\": " << options.nearest << ",\n"
+		<< "  \"reorder\": " << options.reorder << ",\n"
+		<< "  \"cell_size\": " << stats.cell_size << ",\n"
+		<< "  \"reach\": " << stats.reach << ",\n"
+		<< "  \"mean_occupancy\": " << stats.mean_occupancy << ",\n"
+		<< "  \"max_occupancy\": " << stats.max_occupancy << ",\n"
+		<< "  \"candidates_per_query\": " << stats.candidates << ",\n"
+		<< "  \"candidate_ratio\": " << stats.candidate_ratio << ",\n"
+		<< "  \"migrations_per_tick\": " << static_cast<double>(migrations) / options.ticks << ",\n"
+		<< "  \"ns_per_boid_tick\": " << total / std::max(1LL, active) << ",\n"
+		<< "  \"tick_ms\": {"
+		<< " \"mean\": " << total / options.ticks / NS_PER_MS
+		<< ", \"p50\": " << percentile(sorted, 0.50) / NS_PER_MS
+		<< ", \"p90\": " << percentile(sorted, 0.90) / NS_PER_MS
+		<< ", \"p99\": " << percentile(sorted, 0.99) / NS_PER_MS
+		<< ", \"max\": " << sorted.back() / NS_PER_MS << " },\n"
+		<< "  \"peak_memory_bytes\": " << peakMemory() << "\n"
+		<< "}\n";
+	return 0;
+}
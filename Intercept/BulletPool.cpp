@@ -0,0 +1,216 @@
+#include "BulletPool.hpp"
+#include "Simd.hpp"
+#include "Utilise.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BulletPool::BulletPool(int capacity, float radius, float growth, int max_capacity)
+	: m_radius(radius)
+	, m_growth(growth)
+	, m_max_capacity(std::min(std::max(1, max_capacity), static_cast<int>(SlotMap::MAX_SLOTS)))
+	, m_count(0)
+	, m_capacity(0)
+	, m_dropped(0)
+{
+	allocate(std::min(std::max(1, capacity), m_max_capacity));
+	// Same polygon as an sf::CircleShape with OUTLINE_POINTS points, centred
+	for (int i = 0; i < OUTLINE_POINTS; i++)
+	{
+		float angle = i * 2.f * Utilise::PI / OUTLINE_POINTS - Utilise::PI / 2.f;
+		m_outline[i] = sf::Vector2f(radius * std::cos(angle), radius * std::sin(angle));
+	}
+}
+
+SlotMap::Handle BulletPool::spawn(sf::Vector2f position, sf::Vector2f velocity)
+{
+	if (m_count == m_capacity && !grow())
+	{
+		m_dropped++;
+		return SlotMap::NONE;
+	}
+	SlotMap::Handle handle = m_handles.insert();
+	if (handle == SlotMap::NONE)
+	{
+		m_dropped++;
+		return handle;
+	}
+	m_x[m_count] = position.x;
+	m_y[m_count] = position.y;
+	m_vx[m_count] = velocity.x;
+	m_vy[m_count] = velocity.y;
+	m_count++;
+	return handle;
+}
+
+void BulletPool::despawn(int id)
+{
+	m_handles.erase(m_handles.handleAt(id));
+	int last = --m_count;
+	m_x[id] = m_x[last];
+	m_y[id] = m_y[last];
+	m_vx[id] = m_vx[last];
+	m_vy[id] = m_vy[last];
+}
+
+void BulletPool::update(sf::Time dt, sf::FloatRect bounds)
+{
+	float t = dt.asSeconds();
+	// A body is out once its centre is more than a radius past an edge
+	float min_x = bounds.left - m_radius, max_x = bounds.left + bounds.width + m_radius;
+	float min_y = bounds.top - m_radius, max_y = bounds.top + bounds.height + m_radius;
+	std::fill(m_culled.begin(), m_culled.begin() + (m_count + CULL_BLOCK - 1) / CULL_BLOCK, 0);
+	float* x = m_x.data();
+	float* y = m_y.data();
+	const float* vx = m_vx.data();
+	const float* vy = m_vy.data();
+	int i = 0;
+#if defined(AI_SIMD_AVX2)
+	const __m256 step = _mm256_set1_ps(t);
+	const __m256 left = _mm256_set1_ps(min_x), right = _mm256_set1_ps(max_x);
+	const __m256 top = _mm256_set1_ps(min_y), bottom = _mm256_set1_ps(max_y);
+	for (; i + 8 <= m_count; i += 8)
+	{
+		__m256 px = _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(_mm256_load_ps(vx + i), step));
+		__m256 py = _mm256_add_ps(_mm256_load_ps(y + i), _mm256_mul_ps(_mm256_load_ps(vy + i), step));
+		_mm256_store_ps(x + i, px);
+		_mm256_store_ps(y + i, py);
+		__m256 out = _mm256_or_ps(
+			_mm256_or_ps(_mm256_cmp_ps(px, left, _CMP_LT_OQ), _mm256_cmp_ps(px, right, _CMP_GT_OQ)),
+			_mm256_or_ps(_mm256_cmp_ps(py, top, _CMP_LT_OQ), _mm256_cmp_ps(py, bottom, _CMP_GT_OQ)));
+		m_culled[i / CULL_BLOCK] = static_cast<std::uint8_t>(_mm256_movemask_ps(out));
+	}
+#elif defined(AI_SIMD_SSE2)
+	const __m128 step = _mm_set1_ps(t);
+	const __m128 left = _mm_set1_ps(min_x), right = _mm_set1_ps(max_x);
+	const __m128 top = _mm_set1_ps(min_y), bottom = _mm_set1_ps(max_y);
+	for (; i + 4 <= m_count; i += 4)
+	{
+		__m128 px = _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(_mm_load_ps(vx + i), step));
+		__m128 py = _mm_add_ps(_mm_load_ps(y + i), _mm_mul_ps(_mm_load_ps(vy + i), step));
+		_mm_store_ps(x + i, px);
+		_mm_store_ps(y + i, py);
+		__m128 out = _mm_or_ps(
+			_mm_or_ps(_mm_cmplt_ps(px, left), _mm_cmpgt_ps(px, right)),
+			_mm_or_ps(_mm_cmplt_ps(py, top), _mm_cmpgt_ps(py, bottom)));
+		m_culled[i / CULL_BLOCK] |= static_cast<std::uint8_t>(_mm_movemask_ps(out) << (i % CULL_BLOCK));
+	}
+#endif
+	for (; i < m_count; i++)
+	{
+		x[i] += vx[i] * t;
+		y[i] += vy[i] * t;
+		if (x[i] < min_x || x[i] > max_x || y[i] < min_y || y[i] > max_y)
+			m_culled[i / CULL_BLOCK] |= static_cast<std::uint8_t>(1 << (i % CULL_BLOCK));
+	}
+
+	// Backwards, so the bullet moved into a freed slot has already been checked
+	for (int block = (m_count - 1) / CULL_BLOCK; block >= 0; block--)
+	{
+		std::uint8_t mask = m_culled[block];
+		for (int bit = CULL_BLOCK - 1; mask != 0 && bit >= 0; bit--)
+			if (mask & (1 << bit))
+			{
+				despawn(block * CULL_BLOCK + bit);
+				mask &= ~(1 << bit);
+			}
+	}
+}
+
+void BulletPool::render(sf::RenderTarget& target)
+{
+	const int VERTICES = 3 * OUTLINE_POINTS;
+	m_vertices.resize(static_cast<std::size_t>(m_count) * VERTICES);
+	for (int i = 0; i < m_count; i++)
+	{
+		sf::Vector2f centre(m_x[i], m_y[i]);
+		sf::Vertex* out = &m_vertices[static_cast<std::size_t>(i) * VERTICES];
+		for (int j = 0; j < OUTLINE_POINTS; j++)
+		{
+			out[3 * j].position = centre;
+			out[3 * j + 1].position = centre + m_outline[j];
+			out[3 * j + 2].position = centre + m_outline[(j + 1) % OUTLINE_POINTS];
+		}
+	}
+	if (!m_vertices.empty())
+		target.draw(m_vertices.data(), m_vertices.size(), sf::Triangles);
+}
+
+int BulletPool::indexOf(SlotMap::Handle handle) const
+{
+	return m_handles.indexOf(handle);
+}
+
+SlotMap::Handle BulletPool::getHandle(int id) const
+{
+	return m_handles.handleAt(id);
+}
+
+int BulletPool::getCount() const
+{
+	return m_count;
+}
+
+int BulletPool::getCapacity() const
+{
+	return m_capacity;
+}
+
+int BulletPool::getDropCount() const
+{
+	return m_dropped;
+}
+
+float BulletPool::getRadius() const
+{
+	return m_radius;
+}
+
+sf::Vector2f BulletPool::getPosition(int id) const
+{
+	return sf::Vector2f(m_x[id], m_y[id]);
+}
+
+sf::Vector2f BulletPool::getVelocity(int id) const
+{
+	return sf::Vector2f(m_vx[id], m_vy[id]);
+}
+
+const float* BulletPool::positionX() const
+{
+	return m_x.data();
+}
+
+const float* BulletPool::positionY() const
+{
+	return m_y.data();
+}
+
+const float* BulletPool::velocityX() const
+{
+	return m_vx.data();
+}
+
+const float* BulletPool::velocityY() const
+{
+	return m_vy.data();
+}
+
+bool BulletPool::grow()
+{
+	int capacity = static_cast<int>(std::min(static_cast<float>(m_max_capacity), std::ceil(m_capacity * m_growth)));
+	if (capacity <= m_capacity)
+		return false;
+	allocate(capacity);
+	return true;
+}
+
+void BulletPool::allocate(int capacity)
+{
+	m_capacity = capacity;
+	m_x.resize(capacity);
+	m_y.resize(capacity);
+	m_vx.resize(capacity);
+	m_vy.resize(capacity);
+	m_culled.resize((capacity + CULL_BLOCK - 1) / CULL_BLOCK);
+}
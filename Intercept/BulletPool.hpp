@@ -0,0 +1,88 @@
+#ifndef AI_INTERCEPT_BULLET_POOL
+#define AI_INTERCEPT_BULLET_POOL
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "AlignedArray.hpp"
+#include "SlotMap.hpp"
+
+// Bullets in structure-of-arrays storage. Live bullets are the first getCount()
+// entries of every array: spawning appends and despawning moves the last bullet
+// into the freed index, so every pass only touches live bullets. Each bullet also
+// gets a handle that keeps naming it across those moves.
+class BulletPool
+{
+public:
+	// capacity bullets are allocated up front. A full pool grows by the factor growth,
+	// up to max_capacity, at most SlotMap::MAX_SLOTS. Past it, or with growth <= 1,
+	// new bullets are dropped and counted.
+	BulletPool(int capacity, float radius, float growth = 2.f, int max_capacity = 1 << 20);
+
+	// Returns SlotMap::NONE if the bullet was dropped
+	SlotMap::Handle spawn(sf::Vector2f position, sf::Vector2f velocity);
+
+	// The last bullet takes index id
+	void despawn(int id);
+
+	// Index of the bullet, -1 once it is gone
+	int indexOf(SlotMap::Handle handle) const;
+
+	SlotMap::Handle getHandle(int id) const;
+
+	// Moves every bullet and despawns those whose body left bounds.
+	// Uses AVX2 or SSE2 when available.
+	void update(sf::Time dt, sf::FloatRect bounds);
+
+	void render(sf::RenderTarget& target);
+
+	int getCount() const;
+
+	int getCapacity() const;
+
+	// Bullets dropped because the pool could not grow
+	int getDropCount() const;
+
+	float getRadius() const;
+
+	sf::Vector2f getPosition(int id) const;
+
+	sf::Vector2f getVelocity(int id) const;
+
+	const float* positionX() const;
+
+	const float* positionY() const;
+
+	const float* velocityX() const;
+
+	const float* velocityY() const;
+private:
+	// Bullets per byte of m_culled
+	static const int CULL_BLOCK = 8;
+	static const int OUTLINE_POINTS = 7;
+private:
+	bool grow();
+
+	void allocate(int capacity);
+private:
+	float m_radius;
+	float m_growth;
+	int m_max_capacity;
+	int m_count;
+	int m_capacity;
+	int m_dropped;
+	AlignedArray<float> m_x;
+	AlignedArray<float> m_y;
+	AlignedArray<float> m_vx;
+	AlignedArray<float> m_vy;
+	SlotMap m_handles;
+	// One bit per bullet, set by update when it left the bounds
+	std::vector<std::uint8_t> m_culled;
+	// Body shared by every bullet, and the triangles of the last render
+	sf::Vector2f m_outline[OUTLINE_POINTS];
+	std::vector<sf::Vertex> m_vertices;
+};
+
+#endif
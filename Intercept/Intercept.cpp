@@ -4,129 +4,49 @@
 #include <iostream>
 #include <vector>
 #include <set>
-#include <memory>
 #include <cmath>
-#include <queue>
+#include <ctime>
+#include <limits>
+#include <algorithm>
 
 #include <SFML/Graphics.hpp>
 
 #include "Utilise.hpp"
+#include "BulletPool.hpp"
+#include "InterceptSolver.hpp"
+#include "Random.hpp"
+#include "SweepAndPrune.hpp"
+#include "TargetSet.hpp"
 
 using namespace Utilise;
 
 const float BULLET_RADIUS = 10.f;
 
-class Bullet : public sf::Drawable, public sf::Transformable
-{
-public:
-	typedef std::unique_ptr<Bullet> Ptr;
-public:
-	Bullet(sf::Vector2f pos = sf::Vector2f(), sf::Vector2f vel = sf::Vector2f())
-		: m_velocity(vel)
-		, m_body(BULLET_RADIUS, 7)
-	{
-		sf::Transformable::setPosition(pos);
-		center(m_body);
-	};
-
-	void update(sf::Time dt)
-	{
-		sf::Transformable::move(m_velocity * dt.asSeconds());
-	}
-
-	sf::FloatRect getBounds() const
-	{
-		return getTransform().transformRect(m_body.getGlobalBounds());
-	};
-
-	void setVelocity(sf::Vector2f vel)
-	{
-		m_velocity = vel;
-	}
-
-private:
-	void draw(sf::RenderTarget& target, sf::RenderStates states) const override
-	{
-		states.transform *= getTransform();
-		target.draw(m_body, states);
-	};
-private:
-	sf::Vector2f m_velocity;
-	sf::CircleShape m_body;
-};
-
-class BulletManager
-{
-public:
-	BulletManager(sf::RenderWindow* win, int size)
-		: m_window(win)
-		, m_active(size)
-	{
-		for (int i = 0; i < size; i++)
-		{
-			m_IDs.push(i);
-			m_bullets.push_back(Bullet::Ptr(std::make_unique<Bullet>()));
-		}
-	};
-
-	void update(sf::Time dt)
-	{
-		sf::FloatRect screen = sf::FloatRect(sf::Vector2f(), sf::Vector2f(m_window->getSize()));
-		std::vector<int> mark;
-		for (int i = 0; i < m_bullets.size(); i++)
-			if (m_active[i])
-			{
-				m_bullets[i]->update(dt);
-				sf::FloatRect bounds = m_bullets[i]->getBounds();
-				if (!bounds.intersects(screen))
-					mark.push_back(i);
-			}
-		for (auto& i : mark)
-			erase(i);
-	};
-
-	void add(sf::Vector2f pos, sf::Vector2f vel)
-	{
-		if (m_IDs.empty())
-			return;
-		int new_ID = m_IDs.front();
-		m_IDs.pop();
-		m_active[new_ID] = true;
-		m_bullets[new_ID]->setPosition(pos);
-		m_bullets[new_ID]->setVelocity(vel);
-	};
-
-	void render()
-	{
-		for (int i = 0; i < m_bullets.size(); i++)
-			if (m_active[i])
-				m_window->draw(*m_bullets[i]);
-	}
-private:
-	void erase(int id)
-	{
-		m_IDs.push(id);
-		m_active[id] = false;
-	};
-private:
-	sf::RenderWindow* m_window;
-	std::queue<int> m_IDs;
-	std::vector<bool> m_active;
-	std::vector<Bullet::Ptr> m_bullets;
-};
-
 class Shooter
 {
 public:
-	Shooter(sf::RenderWindow* win, sf::Time interval, int bullet_count, float bullet_speed)
+	Shooter(sf::RenderWindow* win, sf::Time interval, int bullet_count, float bullet_speed, int target_count, std::uint64_t seed)
 		: m_window(win)
 		, m_interval(interval)
 		, m_body(20, 10)
 		, m_cursor(50, 20)
 		, m_ray(sf::Lines, 2)
-		, m_bullets(win, bullet_count)
+		, m_bullets(bullet_count, BULLET_RADIUS)
 		, m_speed(bullet_speed)
+		, m_random(seed)
 	{
+		for (int i = 0; i < target_count; i++)
+			m_targets.add(randomPosition(), sf::Vector2f(m_random.uniform(-100.f, 100.f), m_random.uniform(-100.f, 100.f)), m_random.uniform(15.f, 30.f));
+		// Thin walls around the gun, bullets stop at them
+		m_walls = { { 400.f, 250.f, 200.f, 6.f }, { 400.f, 744.f, 200.f, 6.f }, { 250.f, 400.f, 6.f, 200.f }, { 744.f, 400.f, 6.f, 200.f } };
+		m_wall_shape.setPrimitiveType(sf::Quads);
+		for (const sf::FloatRect& wall : m_walls)
+		{
+			m_wall_shape.append(sf::Vertex(sf::Vector2f(wall.left, wall.top), sf::Color(0x999999ff)));
+			m_wall_shape.append(sf::Vertex(sf::Vector2f(wall.left + wall.width, wall.top), sf::Color(0x999999ff)));
+			m_wall_shape.append(sf::Vertex(sf::Vector2f(wall.left + wall.width, wall.top + wall.height), sf::Color(0x999999ff)));
+			m_wall_shape.append(sf::Vertex(sf::Vector2f(wall.left, wall.top + wall.height), sf::Color(0x999999ff)));
+		}
 		m_prev_pos = sf::Vector2f(sf::Mouse::getPosition(*m_window));
 		m_new_pos = m_prev_pos;
 		m_predict = m_prev_pos;
@@ -141,13 +61,17 @@ public:
 
 	void update(sf::Time dt)
 	{
-		m_bullets.update(dt);
+		sf::FloatRect screen(sf::Vector2f(), sf::Vector2f(m_window->getSize()));
+		collide(dt);
+		m_bullets.update(dt, screen);
+		m_targets.update(dt, screen);
 		m_current_time += dt;
 		m_prev_pos = m_new_pos;
 		m_new_pos = sf::Vector2f(sf::Mouse::getPosition(*m_window));
-		sf::Time time_to_meet = std::min(sf::seconds(0.3f), sf::seconds(lengthOf(m_predict - m_body.getPosition()) / m_speed));
 		sf::Vector2f mouse_velo = (m_new_pos - m_prev_pos) / dt.asSeconds();
-		m_predict = m_new_pos + mouse_velo * time_to_meet.asSeconds();
+		// A mouse outrunning the bullets cannot be met, aim where it is then
+		float time_to_meet = InterceptSolver::solve(m_body.getPosition(), m_speed, m_new_pos, mouse_velo);
+		m_predict = time_to_meet >= 0.f ? m_new_pos + mouse_velo * time_to_meet : m_new_pos;
 
 		m_cursor.setPosition(lerp(m_cursor.getPosition(), m_predict, 0.1f));
 		m_ray[0].position = m_body.getPosition();
@@ -162,15 +86,42 @@ public:
 
 	void render()
 	{
+		m_window->draw(m_wall_shape);
+		m_targets.render(*m_window);
 		m_window->draw(m_cursor);
 		m_window->draw(m_ray);
 		m_window->draw(m_body);
-		m_bullets.render();
+		m_bullets.render(*m_window);
 	}
 private:
+	// Sweeps the coming step, so fast bullets cannot skip over a target or a wall.
+	// A bullet stops at its first contact: walls shield the targets behind them.
+	void collide(sf::Time dt)
+	{
+		m_collision.collide(m_bullets, m_targets, m_walls, dt);
+		m_first_contact.assign(m_bullets.getCount(), std::numeric_limits<float>::infinity());
+		for (const Hit& hit : m_collision.getWallHits())
+			m_first_contact[hit.bullet] = std::min(m_first_contact[hit.bullet], hit.time);
+		for (const Hit& hit : m_collision.getHits())
+			m_first_contact[hit.bullet] = std::min(m_first_contact[hit.bullet], hit.time);
+		for (const Hit& hit : m_collision.getHits())
+			if (hit.time == m_first_contact[hit.bullet])
+				m_targets.setPosition(hit.target, randomPosition());
+		// From the highest index down, so swap removal never moves a bullet still to check
+		for (int id = m_bullets.getCount() - 1; id >= 0; id--)
+			if (m_first_contact[id] <= 1.f)
+				m_bullets.despawn(id);
+	}
+
+	sf::Vector2f randomPosition()
+	{
+		sf::Vector2f size(m_window->getSize());
+		return sf::Vector2f(m_random.uniform(0.f, size.x), m_random.uniform(0.f, size.y));
+	}
+
 	void shoot(sf::Time dt)
 	{
-		m_bullets.add(m_body.getPosition(), m_speed * normalise(m_predict - m_body.getPosition()));
+		m_bullets.spawn(m_body.getPosition(), m_speed * normalise(m_predict - m_body.getPosition()));
 	};
 private:
 	sf::RenderWindow* m_window;
@@ -179,12 +130,18 @@ private:
 	sf::Vector2f m_prev_pos;
 	sf::Vector2f m_new_pos;
 	sf::Vector2f m_predict;
-	BulletManager m_bullets;
+	BulletPool m_bullets;
 	float m_speed;
+	TargetSet m_targets;
+	SweepAndPrune m_collision;
+	std::vector<sf::FloatRect> m_walls;
+	std::vector<float> m_first_contact;
+	Random m_random;
 
 	sf::CircleShape m_body;
 	sf::CircleShape m_cursor;
 	sf::VertexArray m_ray;
+	sf::VertexArray m_wall_shape;
 };
 
 int main()
@@ -194,7 +151,7 @@ int main()
 	sf::Time elapsed = clock.restart();
 	sf::Time TPF = sf::seconds(1.f / 60);
 
-	Shooter bao(&win, sf::seconds(0.2f), 20, 500);
+	Shooter bao(&win, sf::seconds(0.2f), 20, 500, 20, static_cast<std::uint64_t>(time(0)));
 
 	while (win.isOpen())
 	{
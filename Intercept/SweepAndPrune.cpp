@@ -0,0 +1,168 @@
+#include "SweepAndPrune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+SweepAndPrune::SweepAndPrune()
+	: m_serial(1)
+{ }
+
+void SweepAndPrune::collide(const BulletPool& bullets, const TargetSet& targets, const std::vector<sf::FloatRect>& walls, sf::Time dt)
+{
+	m_hits.clear();
+	m_wall_hits.clear();
+	float t = dt.asSeconds();
+	int bullet_count = bullets.getCount();
+	int target_count = targets.getCount();
+
+	// Everything is keyed by the left end of its move. Bullets share one radius,
+	// so it is left out of their keys.
+	const float* bx = bullets.positionX();
+	const float* by = bullets.positionY();
+	const float* bvx = bullets.velocityX();
+	const float* bvy = bullets.velocityY();
+	m_bullet_keys.resize(bullet_count);
+	float max_sweep = 0.f;
+	for (int i = 0; i < bullet_count; i++)
+	{
+		float dx = bvx[i] * t;
+		m_bullet_keys[i] = std::min(bx[i], bx[i] + dx);
+		max_sweep = std::max(max_sweep, std::abs(dx));
+	}
+	refresh(m_bullet_order, m_bullet_keys.data(), bullet_count);
+	const float* tx = targets.positionX();
+	const float* ty = targets.positionY();
+	const float* tr = targets.radius();
+	m_target_keys.resize(target_count);
+	for (int i = 0; i < target_count; i++)
+		m_target_keys[i] = std::min(tx[i], tx[i] + targets.getVelocity(i).x * t) - tr[i];
+	refresh(m_target_order, m_target_keys.data(), target_count);
+
+	m_sorted_left.resize(bullet_count);
+	m_sorted_x.resize(bullet_count);
+	m_sorted_y.resize(bullet_count);
+	m_sorted_dx.resize(bullet_count);
+	m_sorted_dy.resize(bullet_count);
+	m_sorted_ids.resize(bullet_count);
+	for (int i = 0; i < bullet_count; i++)
+	{
+		int id = m_bullet_order[i].id;
+		m_sorted_left[i] = m_bullet_order[i].key;
+		m_sorted_x[i] = bx[id];
+		m_sorted_y[i] = by[id];
+		m_sorted_dx[i] = bvx[id] * t;
+		m_sorted_dy[i] = bvy[id] * t;
+		m_sorted_ids[i] = id;
+	}
+	SweptCircles swept{ m_sorted_x.data(), m_sorted_y.data(), m_sorted_dx.data(), m_sorted_dy.data(), bullets.getRadius() };
+
+	// A bullet reaches back at most its radius and the longest move past its key.
+	// Targets come in order of their left end, so the first bullet that can
+	// reach the current one only moves forward.
+	float behind = bullets.getRadius() + max_sweep, ahead = bullets.getRadius();
+	const float* sorted = m_sorted_left.data();
+	const float* sorted_end = sorted + bullet_count;
+	int first = 0;
+	for (const Proxy& proxy : m_target_order)
+	{
+		while (first < bullet_count && sorted[first] < proxy.key - behind)
+			first++;
+		int id = proxy.id;
+		sf::Vector2f move = targets.getVelocity(id) * t;
+		float right = std::max(tx[id], tx[id] + move.x) + tr[id] + ahead;
+		int last = static_cast<int>(std::upper_bound(sorted + first, sorted_end, right) - sorted);
+		m_contacts.clear();
+		sweepAgainstCircle(swept, first, last, sf::Vector2f(tx[id], ty[id]), move, tr[id], m_contacts);
+		for (const Contact& contact : m_contacts)
+			m_hits.push_back(Hit{ m_sorted_ids[contact.index], id, contact.time });
+	}
+
+	for (int id = 0; id < static_cast<int>(walls.size()); id++)
+	{
+		const sf::FloatRect& wall = walls[id];
+		int lo = static_cast<int>(std::lower_bound(sorted, sorted_end, wall.left - behind) - sorted);
+		int hi = static_cast<int>(std::upper_bound(sorted + lo, sorted_end, wall.left + wall.width + ahead) - sorted);
+		m_contacts.clear();
+		sweepAgainstBox(swept, lo, hi, wall, m_contacts);
+		for (const Contact& contact : m_contacts)
+			m_wall_hits.push_back(Hit{ m_sorted_ids[contact.index], id, contact.time });
+	}
+}
+
+const std::vector<Hit>& SweepAndPrune::getHits() const
+{
+	return m_hits;
+}
+
+const std::vector<Hit>& SweepAndPrune::getWallHits() const
+{
+	return m_wall_hits;
+}
+
+void SweepAndPrune::refresh(std::vector<Proxy>& order, const float* keys, int count)
+{
+	if (count < static_cast<int>(order.size()))
+		order.erase(std::remove_if(order.begin(), order.end(), [count](const Proxy& p) { return p.id >= count; }), order.end());
+	for (int id = static_cast<int>(order.size()); id < count; id++)
+		order.push_back(Proxy{ 0.f, id });
+	for (Proxy& p : order)
+		p.key = keys[p.id];
+
+	// Both ends of every descent are pulled out until the rest is sorted. New,
+	// renamed and teleported objects go that way, along with the few that crossed
+	// a neighbour. Only those are sorted, then merged back in linear time.
+	m_run.assign(order.begin(), order.end());
+	m_stragglers.clear();
+	std::size_t limit = order.size() / STRAGGLER_FRACTION;
+	for (int pass = 0; ; pass++)
+	{
+		std::size_t size = m_run.size(), kept = 0, pulled = m_stragglers.size();
+		float previous = -std::numeric_limits<float>::infinity();
+		for (std::size_t i = 0; i < size; i++)
+		{
+			Proxy p = m_run[i];
+			if (p.key < previous || (i + 1 < size && p.key > m_run[i + 1].key))
+				m_stragglers.push_back(p);
+			else
+				m_run[kept++] = p;
+			previous = p.key;
+		}
+		m_run.resize(kept);
+		if (m_stragglers.size() == pulled)
+			break;
+		// Too little coherence left to be worth it
+		if (m_stragglers.size() > limit || pass + 1 == MAX_PASSES)
+		{
+			sortAll(order, keys);
+			return;
+		}
+	}
+	if (m_stragglers.empty())
+		return;
+	auto less = [](const Proxy& a, const Proxy& b) { return a.key < b.key; };
+	std::sort(m_stragglers.begin(), m_stragglers.end(), less);
+	std::merge(m_run.begin(), m_run.end(), m_stragglers.begin(), m_stragglers.end(), order.begin(), less);
+}
+
+void SweepAndPrune::sortAll(std::vector<Proxy>& order, const float* keys)
+{
+	std::size_t size = order.size();
+	m_sort_keys.resize(size);
+	m_sort_ids.resize(size);
+	for (std::size_t i = 0; i < size; i++)
+	{
+		// Flips the order of negative floats, then puts them below positive ones
+		std::uint32_t bits;
+		std::memcpy(&bits, &order[i].key, sizeof(bits));
+		m_sort_keys[i] = bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+		m_sort_ids[i] = static_cast<std::uint32_t>(order[i].id);
+	}
+	m_radix.sort(m_sort_keys, m_sort_ids, m_serial);
+	for (std::size_t i = 0; i < size; i++)
+	{
+		int id = static_cast<int>(m_sort_ids[i]);
+		order[i] = Proxy{ keys[id], id };
+	}
+}
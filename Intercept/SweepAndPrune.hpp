@@ -0,0 +1,83 @@
+#ifndef AI_INTERCEPT_SWEEP_AND_PRUNE
+#define AI_INTERCEPT_SWEEP_AND_PRUNE
+
+#include <cstdint>
+#include <vector>
+
+#include "AlignedArray.hpp"
+#include "BulletPool.hpp"
+#include "RadixSort.hpp"
+#include "SweptCircle.hpp"
+#include "TargetSet.hpp"
+
+struct Hit
+{
+	int bullet;
+	// Target or wall index
+	int target;
+	// Time of impact as a fraction of the step
+	float time;
+};
+
+// Bullet against target broadphase along the x axis, over the interval each one
+// sweeps during a step. Both sides stay sorted between calls and only the entries
+// that fell out of order are re-sorted, which is close to linear while things
+// move a little per tick. Candidate pairs get the exact swept test, so fast
+// bullets cannot pass through a target between two ticks.
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+
+	// Refills the hit buffers with every pair that touches while bullets and
+	// targets move for dt from where they are now, ordered by target along the
+	// sweep axis. A zero dt tests for overlap. Uses AVX2 or SSE2 when available.
+	void collide(const BulletPool& bullets, const TargetSet& targets, const std::vector<sf::FloatRect>& walls, sf::Time dt);
+
+	const std::vector<Hit>& getHits() const;
+
+	const std::vector<Hit>& getWallHits() const;
+private:
+	struct Proxy
+	{
+		float key;
+		int id;
+	};
+	// refresh sorts everything once more than 1 / STRAGGLER_FRACTION of the
+	// entries are out of order, or after MAX_PASSES
+	static const int STRAGGLER_FRACTION = 4;
+	static const int MAX_PASSES = 8;
+private:
+	// Brings order up to date with ids [0, count), starting from the last order.
+	// Objects are swap-removed, so an id may now name another object: its key is
+	// simply out of place and gets sorted like any other.
+	void refresh(std::vector<Proxy>& order, const float* keys, int count);
+
+	// Radix sort of order by key
+	void sortAll(std::vector<Proxy>& order, const float* keys);
+private:
+	std::vector<Proxy> m_bullet_order;
+	std::vector<Proxy> m_target_order;
+	AlignedArray<float> m_bullet_keys;
+	AlignedArray<float> m_target_keys;
+	// Bullets in sweep order, with their move over the step
+	AlignedArray<float> m_sorted_left;
+	AlignedArray<float> m_sorted_x;
+	AlignedArray<float> m_sorted_y;
+	AlignedArray<float> m_sorted_dx;
+	AlignedArray<float> m_sorted_dy;
+	std::vector<int> m_sorted_ids;
+	// Scratch of refresh
+	std::vector<Proxy> m_run;
+	std::vector<Proxy> m_stragglers;
+	RadixSort m_radix;
+	// No threads, the sweep runs on the calling one
+	WorkerPool m_serial;
+	std::vector<std::uint32_t> m_sort_keys;
+	std::vector<std::uint32_t> m_sort_ids;
+	std::vector<Contact> m_contacts;
+	std::vector<Hit> m_hits;
+	std::vector<Hit> m_wall_hits;
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "SweptCircle.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const float INF = std::numeric_limits<float>::infinity();
+	// Stands for 1 / 0 on axes with no movement, keeps the slab products finite
+	const float HUGE_INVERSE = 1e30f;
+
+	float inverse(float value)
+	{
+		return value == 0.f ? HUGE_INVERSE : 1.f / value;
+	}
+
+	// Circle offset by (px, py) from a static one and moving by (mx, my).
+	// reach is the sum of both radii. INF if they do not touch within the move.
+	float circleTime(float px, float py, float mx, float my, float reach_squared)
+	{
+		float c = px * px + py * py - reach_squared;
+		if (c <= 0.f)
+			return 0.f;
+		float b = px * mx + py * my;
+		if (b >= 0.f)
+			return INF;
+		float a = mx * mx + my * my;
+		float discriminant = b * b - a * c;
+		if (discriminant < 0.f)
+			return INF;
+		float t = (-b - std::sqrt(discriminant)) / a;
+		return t <= 1.f ? t : INF;
+	}
+
+	// Point moving by 1 / (ix, iy) against a box. INF if it misses within the move.
+	float slabTime(float x, float y, float ix, float iy, float min_x, float min_y, float max_x, float max_y)
+	{
+		float t1x = (min_x - x) * ix, t2x = (max_x - x) * ix;
+		float t1y = (min_y - y) * iy, t2y = (max_y - y) * iy;
+		float entry = std::max(std::min(t1x, t2x), std::min(t1y, t2y));
+		float exit = std::min(std::max(t1x, t2x), std::max(t1y, t2y));
+		if (entry <= exit && exit >= 0.f && entry <= 1.f)
+			return std::max(entry, 0.f);
+		return INF;
+	}
+
+	void append(int first, int mask, const float* times, std::vector<Contact>& contacts)
+	{
+		for (int bit = 0; mask != 0; bit++, mask >>= 1)
+			if (mask & 1)
+				contacts.push_back(Contact{ first + bit, times[bit] });
+	}
+
+#if defined(AI_SIMD_AVX2)
+	__m256 select(__m256 mask, __m256 a, __m256 b)
+	{
+		return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+	}
+
+	__m256 inverse(__m256 value)
+	{
+		__m256 zero = _mm256_setzero_ps();
+		return select(_mm256_cmp_ps(value, zero, _CMP_EQ_OQ), _mm256_set1_ps(HUGE_INVERSE), _mm256_div_ps(_mm256_set1_ps(1.f), value));
+	}
+
+	__m256 circleTime(__m256 px, __m256 py, __m256 mx, __m256 my, __m256 reach_squared)
+	{
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), inf = _mm256_set1_ps(INF);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), reach_squared);
+		__m256 b = _mm256_add_ps(_mm256_mul_ps(px, mx), _mm256_mul_ps(py, my));
+		__m256 a = _mm256_add_ps(_mm256_mul_ps(mx, mx), _mm256_mul_ps(my, my));
+		__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+		__m256 touching = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+		__m256 closing = _mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ), _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ));
+		// Most pairs miss, skip the square root and division then
+		if (!_mm256_movemask_ps(_mm256_or_ps(touching, closing)))
+			return inf;
+		__m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+		__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), root), a);
+		__m256 hit = _mm256_and_ps(closing, _mm256_cmp_ps(t, one, _CMP_LE_OQ));
+		return select(touching, zero, select(hit, t, inf));
+	}
+
+	__m256 slabTime(__m256 x, __m256 y, __m256 ix, __m256 iy, __m256 min_x, __m256 min_y, __m256 max_x, __m256 max_y)
+	{
+		const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), inf = _mm256_set1_ps(INF);
+		__m256 t1x = _mm256_mul_ps(_mm256_sub_ps(min_x, x), ix), t2x = _mm256_mul_ps(_mm256_sub_ps(max_x, x), ix);
+		__m256 t1y = _mm256_mul_ps(_mm256_sub_ps(min_y, y), iy), t2y = _mm256_mul_ps(_mm256_sub_ps(max_y, y), iy);
+		__m256 entry = _mm256_max_ps(_mm256_min_ps(t1x, t2x), _mm256_min_ps(t1y, t2y));
+		__m256 exit = _mm256_min_ps(_mm256_max_ps(t1x, t2x), _mm256_max_ps(t1y, t2y));
+		__m256 hit = _mm256_and_ps(_mm256_and_ps(
+			_mm256_cmp_ps(entry, exit, _CMP_LE_OQ),
+			_mm256_cmp_ps(exit, zero, _CMP_GE_OQ)),
+			_mm256_cmp_ps(entry, one, _CMP_LE_OQ));
+		return select(hit, _mm256_max_ps(entry, zero), inf);
+	}
+#elif defined(AI_SIMD_SSE2)
+	__m128 select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	__m128 inverse(__m128 value)
+	{
+		return select(_mm_cmpeq_ps(value, _mm_setzero_ps()), _mm_set1_ps(HUGE_INVERSE), _mm_div_ps(_mm_set1_ps(1.f), value));
+	}
+
+	__m128 circleTime(__m128 px, __m128 py, __m128 mx, __m128 my, __m128 reach_squared)
+	{
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), inf = _mm_set1_ps(INF);
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), reach_squared);
+		__m128 b = _mm_add_ps(_mm_mul_ps(px, mx), _mm_mul_ps(py, my));
+		__m128 a = _mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my));
+		__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		__m128 touching = _mm_cmple_ps(c, zero);
+		__m128 closing = _mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(discriminant, zero));
+		// Most pairs miss, skip the square root and division then
+		if (!_mm_movemask_ps(_mm_or_ps(touching, closing)))
+			return inf;
+		__m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+		__m128 t = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero, b), root), a);
+		__m128 hit = _mm_and_ps(closing, _mm_cmple_ps(t, one));
+		return select(touching, zero, select(hit, t, inf));
+	}
+
+	__m128 slabTime(__m128 x, __m128 y, __m128 ix, __m128 iy, __m128 min_x, __m128 min_y, __m128 max_x, __m128 max_y)
+	{
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), inf = _mm_set1_ps(INF);
+		__m128 t1x = _mm_mul_ps(_mm_sub_ps(min_x, x), ix), t2x = _mm_mul_ps(_mm_sub_ps(max_x, x), ix);
+		__m128 t1y = _mm_mul_ps(_mm_sub_ps(min_y, y), iy), t2y = _mm_mul_ps(_mm_sub_ps(max_y, y), iy);
+		__m128 entry = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+		__m128 exit = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+		__m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(entry, exit), _mm_cmpge_ps(exit, zero)), _mm_cmple_ps(entry, one));
+		return select(hit, _mm_max_ps(entry, zero), inf);
+	}
+#endif
+}
+
+void sweepAgainstCircle(const SweptCircles& circles, int first, int last, sf::Vector2f centre, sf::Vector2f move, float radius, std::vector<Contact>& contacts)
+{
+	float reach = radius + circles.radius, reach_squared = reach * reach;
+	int i = first;
+#if defined(AI_SIMD_AVX2)
+	if (last - i >= 8)
+	{
+		const __m256 cx = _mm256_set1_ps(centre.x), cy = _mm256_set1_ps(centre.y);
+		const __m256 vx = _mm256_set1_ps(move.x), vy = _mm256_set1_ps(move.y);
+		const __m256 limit = _mm256_set1_ps(reach_squared), inf = _mm256_set1_ps(INF);
+		alignas(32) float times[8];
+		for (; last - i >= 8; i += 8)
+		{
+			__m256 time = circleTime(
+				_mm256_sub_ps(_mm256_loadu_ps(circles.x + i), cx), _mm256_sub_ps(_mm256_loadu_ps(circles.y + i), cy),
+				_mm256_sub_ps(_mm256_loadu_ps(circles.dx + i), vx), _mm256_sub_ps(_mm256_loadu_ps(circles.dy + i), vy),
+				limit);
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(time, inf, _CMP_LT_OQ));
+			if (mask)
+			{
+				_mm256_store_ps(times, time);
+				append(i, mask, times, contacts);
+			}
+		}
+	}
+#elif defined(AI_SIMD_SSE2)
+	if (last - i >= 4)
+	{
+		const __m128 cx = _mm_set1_ps(centre.x), cy = _mm_set1_ps(centre.y);
+		const __m128 vx = _mm_set1_ps(move.x), vy = _mm_set1_ps(move.y);
+		const __m128 limit = _mm_set1_ps(reach_squared), inf = _mm_set1_ps(INF);
+		alignas(16) float times[4];
+		for (; last - i >= 4; i += 4)
+		{
+			__m128 time = circleTime(
+				_mm_sub_ps(_mm_loadu_ps(circles.x + i), cx), _mm_sub_ps(_mm_loadu_ps(circles.y + i), cy),
+				_mm_sub_ps(_mm_loadu_ps(circles.dx + i), vx), _mm_sub_ps(_mm_loadu_ps(circles.dy + i), vy),
+				limit);
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(time, inf));
+			if (mask)
+			{
+				_mm_store_ps(times, time);
+				append(i, mask, times, contacts);
+			}
+		}
+	}
+#endif
+	for (; i < last; i++)
+	{
+		float time = circleTime(circles.x[i] - centre.x, circles.y[i] - centre.y, circles.dx[i] - move.x, circles.dy[i] - move.y, reach_squared);
+		if (time < INF)
+			contacts.push_back(Contact{ i, time });
+	}
+}
+
+void sweepAgainstBox(const SweptCircles& circles, int first, int last, sf::FloatRect box, std::vector<Contact>& contacts)
+{
+	// The grown box is two slabs, one grown along each axis, and four corner circles
+	float r = circles.radius, r_squared = r * r;
+	float min_x = box.left, min_y = box.top, max_x = box.left + box.width, max_y = box.top + box.height;
+	const float corner_x[4] = { min_x, max_x, min_x, max_x };
+	const float corner_y[4] = { min_y, min_y, max_y, max_y };
+	int i = first;
+#if defined(AI_SIMD_AVX2)
+	if (last - i >= 8)
+	{
+		const __m256 x0 = _mm256_set1_ps(min_x), y0 = _mm256_set1_ps(min_y);
+		const __m256 x1 = _mm256_set1_ps(max_x), y1 = _mm256_set1_ps(max_y);
+		const __m256 grown_x0 = _mm256_set1_ps(min_x - r), grown_y0 = _mm256_set1_ps(min_y - r);
+		const __m256 grown_x1 = _mm256_set1_ps(max_x + r), grown_y1 = _mm256_set1_ps(max_y + r);
+		const __m256 limit = _mm256_set1_ps(r_squared), inf = _mm256_set1_ps(INF);
+		alignas(32) float times[8];
+		for (; last - i >= 8; i += 8)
+		{
+			__m256 x = _mm256_loadu_ps(circles.x + i), y = _mm256_loadu_ps(circles.y + i);
+			__m256 dx = _mm256_loadu_ps(circles.dx + i), dy = _mm256_loadu_ps(circles.dy + i);
+			__m256 ix = inverse(dx), iy = inverse(dy);
+			__m256 time = _mm256_min_ps(
+				slabTime(x, y, ix, iy, grown_x0, y0, grown_x1, y1),
+				slabTime(x, y, ix, iy, x0, grown_y0, x1, grown_y1));
+			for (int c = 0; c < 4; c++)
+				time = _mm256_min_ps(time, circleTime(
+					_mm256_sub_ps(x, _mm256_set1_ps(corner_x[c])), _mm256_sub_ps(y, _mm256_set1_ps(corner_y[c])), dx, dy, limit));
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(time, inf, _CMP_LT_OQ));
+			if (mask)
+			{
+				_mm256_store_ps(times, time);
+				append(i, mask, times, contacts);
+			}
+		}
+	}
+#elif defined(AI_SIMD_SSE2)
+	if (last - i >= 4)
+	{
+		const __m128 x0 = _mm_set1_ps(min_x), y0 = _mm_set1_ps(min_y);
+		const __m128 x1 = _mm_set1_ps(max_x), y1 = _mm_set1_ps(max_y);
+		const __m128 grown_x0 = _mm_set1_ps(min_x - r), grown_y0 = _mm_set1_ps(min_y - r);
+		const __m128 grown_x1 = _mm_set1_ps(max_x + r), grown_y1 = _mm_set1_ps(max_y + r);
+		const __m128 limit = _mm_set1_ps(r_squared), inf = _mm_set1_ps(INF);
+		alignas(16) float times[4];
+		for (; last - i >= 4; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(circles.x + i), y = _mm_loadu_ps(circles.y + i);
+			__m128 dx = _mm_loadu_ps(circles.dx + i), dy = _mm_loadu_ps(circles.dy + i);
+			__m128 ix = inverse(dx), iy = inverse(dy);
+			__m128 time = _mm_min_ps(
+				slabTime(x, y, ix, iy, grown_x0, y0, grown_x1, y1),
+				slabTime(x, y, ix, iy, x0, grown_y0, x1, grown_y1));
+			for (int c = 0; c < 4; c++)
+				time = _mm_min_ps(time, circleTime(
+					_mm_sub_ps(x, _mm_set1_ps(corner_x[c])), _mm_sub_ps(y, _mm_set1_ps(corner_y[c])), dx, dy, limit));
+			int mask = _mm_movemask_ps(_mm_cmplt_ps(time, inf));
+			if (mask)
+			{
+				_mm_store_ps(times, time);
+				append(i, mask, times, contacts);
+			}
+		}
+	}
+#endif
+	for (; i < last; i++)
+	{
+		float x = circles.x[i], y = circles.y[i], dx = circles.dx[i], dy = circles.dy[i];
+		float ix = inverse(dx), iy = inverse(dy);
+		float time = std::min(
+			slabTime(x, y, ix, iy, min_x - r, min_y, max_x + r, max_y),
+			slabTime(x, y, ix, iy, min_x, min_y - r, max_x, max_y + r));
+		for (int c = 0; c < 4; c++)
+			time = std::min(time, circleTime(x - corner_x[c], y - corner_y[c], dx, dy, r_squared));
+		if (time < INF)
+			contacts.push_back(Contact{ i, time });
+	}
+}
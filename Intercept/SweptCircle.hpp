@@ -0,0 +1,34 @@
+#ifndef AI_INTERCEPT_SWEPT_CIRCLE
+#define AI_INTERCEPT_SWEPT_CIRCLE
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Packed circles of one radius, each moving from (x, y) by (dx, dy) over a step
+struct SweptCircles
+{
+	const float* x;
+	const float* y;
+	const float* dx;
+	const float* dy;
+	float radius;
+};
+
+// Circle index, and the time of impact as a fraction of its move
+struct Contact
+{
+	int index;
+	float time;
+};
+
+// Appends a contact for every circle of [first, last) that touches, during the step,
+// a circle of radius starting at centre and moving by move. Circles already touching
+// get time 0. Uses AVX2 or SSE2 when available.
+void sweepAgainstCircle(const SweptCircles& circles, int first, int last, sf::Vector2f centre, sf::Vector2f move, float radius, std::vector<Contact>& contacts);
+
+// Same against a static box. The box is grown by the circle radius with rounded
+// corners, so the time is exact at the corners too.
+void sweepAgainstBox(const SweptCircles& circles, int first, int last, sf::FloatRect box, std::vector<Contact>& contacts);
+
+#endif
@@ -0,0 +1,100 @@
+#include "TargetSet.hpp"
+#include "Utilise.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TargetSet::TargetSet()
+	: m_count(0)
+{
+	for (int i = 0; i < OUTLINE_POINTS; i++)
+	{
+		float angle = i * 2.f * Utilise::PI / OUTLINE_POINTS;
+		m_outline[i] = sf::Vector2f(std::cos(angle), std::sin(angle));
+	}
+}
+
+void TargetSet::add(sf::Vector2f position, sf::Vector2f velocity, float radius)
+{
+	m_x.push_back(position.x);
+	m_y.push_back(position.y);
+	m_vx.push_back(velocity.x);
+	m_vy.push_back(velocity.y);
+	m_radius.push_back(radius);
+	m_count++;
+}
+
+void TargetSet::setPosition(int id, sf::Vector2f position)
+{
+	m_x[id] = position.x;
+	m_y[id] = position.y;
+}
+
+void TargetSet::update(sf::Time dt, sf::FloatRect bounds)
+{
+	float t = dt.asSeconds();
+	float right = bounds.left + bounds.width, bottom = bounds.top + bounds.height;
+	for (int i = 0; i < m_count; i++)
+	{
+		m_x[i] += m_vx[i] * t;
+		m_y[i] += m_vy[i] * t;
+		if ((m_x[i] < bounds.left && m_vx[i] < 0.f) || (m_x[i] > right && m_vx[i] > 0.f))
+			m_vx[i] = -m_vx[i];
+		if ((m_y[i] < bounds.top && m_vy[i] < 0.f) || (m_y[i] > bottom && m_vy[i] > 0.f))
+			m_vy[i] = -m_vy[i];
+	}
+}
+
+void TargetSet::render(sf::RenderTarget& target)
+{
+	const int VERTICES = 3 * OUTLINE_POINTS;
+	m_vertices.resize(static_cast<std::size_t>(m_count) * VERTICES);
+	for (int i = 0; i < m_count; i++)
+	{
+		sf::Vector2f centre(m_x[i], m_y[i]);
+		sf::Vertex* out = &m_vertices[static_cast<std::size_t>(i) * VERTICES];
+		for (int j = 0; j < OUTLINE_POINTS; j++)
+		{
+			out[3 * j] = sf::Vertex(centre, sf::Color::Red);
+			out[3 * j + 1] = sf::Vertex(centre + m_radius[i] * m_outline[j], sf::Color::Red);
+			out[3 * j + 2] = sf::Vertex(centre + m_radius[i] * m_outline[(j + 1) % OUTLINE_POINTS], sf::Color::Red);
+		}
+	}
+	if (!m_vertices.empty())
+		target.draw(m_vertices.data(), m_vertices.size(), sf::Triangles);
+}
+
+int TargetSet::getCount() const
+{
+	return m_count;
+}
+
+sf::Vector2f TargetSet::getPosition(int id) const
+{
+	return sf::Vector2f(m_x[id], m_y[id]);
+}
+
+sf::Vector2f TargetSet::getVelocity(int id) const
+{
+	return sf::Vector2f(m_vx[id], m_vy[id]);
+}
+
+float TargetSet::getRadius(int id) const
+{
+	return m_radius[id];
+}
+
+const float* TargetSet::positionX() const
+{
+	return m_x.data();
+}
+
+const float* TargetSet::positionY() const
+{
+	return m_y.data();
+}
+
+const float* TargetSet::radius() const
+{
+	return m_radius.data();
+}
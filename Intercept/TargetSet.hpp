@@ -0,0 +1,53 @@
+#ifndef AI_INTERCEPT_TARGET_SET
+#define AI_INTERCEPT_TARGET_SET
+
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "AlignedArray.hpp"
+
+// Drifting circular targets, one packed array per field.
+// Removing a target moves the last one into its slot.
+class TargetSet
+{
+public:
+	TargetSet();
+
+	void add(sf::Vector2f position, sf::Vector2f velocity, float radius);
+
+	void setPosition(int id, sf::Vector2f position);
+
+	// Moves every target, bouncing off the edges of bounds
+	void update(sf::Time dt, sf::FloatRect bounds);
+
+	void render(sf::RenderTarget& target);
+
+	int getCount() const;
+
+	sf::Vector2f getPosition(int id) const;
+
+	sf::Vector2f getVelocity(int id) const;
+
+	float getRadius(int id) const;
+
+	const float* positionX() const;
+
+	const float* positionY() const;
+
+	const float* radius() const;
+private:
+	static const int OUTLINE_POINTS = 12;
+private:
+	int m_count;
+	AlignedArray<float> m_x;
+	AlignedArray<float> m_y;
+	AlignedArray<float> m_vx;
+	AlignedArray<float> m_vy;
+	AlignedArray<float> m_radius;
+	// Unit circle outline, and the triangles of the last render
+	sf::Vector2f m_outline[OUTLINE_POINTS];
+	std::vector<sf::Vertex> m_vertices;
+};
+
+#endif
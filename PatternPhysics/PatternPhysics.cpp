@@ -1,7 +1,14 @@
+// Usage: PatternPhysics [--record FILE] [--replay FILE]
+// --record writes a trace of the guard to FILE.
+// --replay plays FILE back without simulating: Space pauses, Left and Right step,
+// dragging the mouse across the window scrubs through the whole trace.
+
 #include <cmath>
 #include <deque>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <string>
 
 #include <SFML/Graphics.hpp>
 
@@ -109,8 +116,64 @@ private:
 	float m_goal_rotation;
 };
 
-int main()
+int replay(const std::string& path)
+{
+	TraceReader trace;
+	if (!trace.open(path) || trace.getFrameCount() == 0 || trace.getEntityCount() != 1)
+	{
+		std::cerr << "Cannot read trace " << path << "\n";
+		return 1;
+	}
+	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
+	sf::Clock clock;
+	sf::Time elapsed = clock.restart();
+	sf::Time TPF = sf::seconds(1.f / 60);
+
+	Rider bao(1300, 300);
+	std::vector<TraceEntity> frame;
+	TracePlayer player(trace.getFrameCount());
+	int shown = -1;
+	while (win.isOpen())
+	{
+		elapsed += clock.restart();
+		sf::Event e;
+		while (win.pollEvent(e))
+		{
+			if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::Escape)
+				win.close();
+			player.processEvent(e);
+		}
+		player.scrub(win);
+		while (elapsed >= TPF)
+		{
+			elapsed -= TPF;
+			player.advance();
+		}
+		if (player.getFrame() != shown && trace.read(player.getFrame(), frame))
+		{
+			shown = player.getFrame();
+			for (const TraceEntity& entity : frame)
+				bao.restore(entity, TPF);
+		}
+		win.clear();
+		win.draw(bao);
+		win.display();
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
 {
+	std::string record_path;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string name = argv[i];
+		if (name == "--replay")
+			return replay(argv[i + 1]);
+		if (name == "--record")
+			record_path = argv[i + 1];
+	}
+
 	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
 	sf::Clock clock;
 	sf::Time elapsed = clock.restart();
@@ -119,6 +182,9 @@ int main()
 
 	Guard bao(1300, 300);
 	bao.setPosition(0, 0);
+	std::unique_ptr<TraceWriter> trace;
+	if (!record_path.empty())
+		trace = std::make_unique<TraceWriter>(record_path, 1, 0, sf::Vector2f(SCREEN_SIZE, SCREEN_SIZE));
 	while (win.isOpen())
 	{
 		sf::Time dt = clock.restart();
@@ -134,6 +200,11 @@ int main()
 		{
 			elapsed -= TPF;
 			bao.update(TPF);
+			if (trace)
+			{
+				bao.record(*trace, 0);
+				trace->endFrame();
+			}
 		}
 		win.clear();
 		win.draw(bao);
@@ -12,36 +12,69 @@ Entity::Entity(float jet_strength, float steer_force)
 	, m_steer_value(steer_force)
 	, m_push_speed(0)
 	, m_drag_constant(0.05f)
-{
-	setPosition(500.f, 500.f);
-	setRotation(-90);
-}
+	, m_position(500.f, 500.f)
+	, m_heading(-90)
+{ }
 
 void Entity::update(sf::Time dt)
 {
+	// steer_ratio changes every tick, so the rotation is built once per tick
 	if (steer == LEFT)
 	{
-		rotate(-abs(m_steer_value) * steer_ratio * dt.asSeconds());
+		m_heading.rotate(Utilise::Rotation(-abs(m_steer_value) * steer_ratio * dt.asSeconds()));
 		direction += -abs(m_steer_value) * steer_ratio * dt.asSeconds();
 	}
 	else if (steer == RIGHT)
 	{
-		rotate(abs(m_steer_value) * steer_ratio * dt.asSeconds());
+		m_heading.rotate(Utilise::Rotation(abs(m_steer_value) * steer_ratio * dt.asSeconds()));
 		direction += -abs(m_steer_value) * steer_ratio * dt.asSeconds();
 	}
 	if (thruster)
 		m_push_speed += push_acceleration * dt.asSeconds();
 	m_push_speed += (-m_drag_constant * m_push_speed * m_push_speed) * dt.asSeconds();
 	m_push_speed = std::max(0.f, m_push_speed);
-	sf::Vector2f velocity(m_push_speed * std::sin(Utilise::toRadian(-getRotation())),
-		m_push_speed * std::cos(Utilise::toRadian(-getRotation())));
-	move(velocity * dt.asSeconds());
+	m_position += getVelocity() * dt.asSeconds();
+}
+
+sf::Vector2f Entity::getVelocity() const
+{
+	// Forward is the local y axis
+	return m_heading.toGlobal(sf::Vector2f(0.f, m_push_speed));
+}
+
+const sf::Vector2f& Entity::getPosition() const
+{
+	return m_position;
+}
+
+void Entity::setPosition(float x, float y)
+{
+	m_position = sf::Vector2f(x, y);
 }
 
-sf::Vector2f Entity::getVelocity()
+void Entity::setPosition(sf::Vector2f position)
 {
-	return sf::Vector2f(m_push_speed * std::sin(Utilise::toRadian(-getRotation())),
-		m_push_speed * std::cos(Utilise::toRadian(-getRotation())));
+	m_position = position;
+}
+
+const Utilise::Heading& Entity::getHeading() const
+{
+	return m_heading;
+}
+
+void Entity::setHeading(const Utilise::Heading& heading)
+{
+	m_heading = heading;
+}
+
+sf::Transform Entity::getTransform() const
+{
+	return m_heading.getTransform(m_position);
+}
+
+int Entity::getState() const
+{
+	return static_cast<int>(steer) | (thruster ? 4 : 0);
 }
 
 Rider::Rider(float jet_strength, float steer_force)
@@ -61,7 +94,28 @@ Rider::Rider(float jet_strength, float steer_force)
 void Rider::update(sf::Time dt)
 {
 	Entity::update(dt);
+	updateTrail(dt);
+}
+
+sf::FloatRect Rider::getBounds()
+{
+	return getTransform().transformRect(m_body.getGlobalBounds());
+}
+
+void Rider::record(TraceWriter& trace, std::uint32_t id) const
+{
+	trace.add(id, getPosition(), getHeading(), Utilise::lengthOf(getVelocity()), getState());
+}
 
+void Rider::restore(const TraceEntity& entity, sf::Time dt)
+{
+	setPosition(entity.position);
+	setHeading(entity.heading);
+	updateTrail(dt);
+}
+
+void Rider::updateTrail(sf::Time dt)
+{
 	m_elapsed_time += dt;
 	while (m_elapsed_time >= m_image_interval)
 	{
@@ -71,11 +125,6 @@ void Rider::update(sf::Time dt)
 	}
 }
 
-sf::FloatRect Rider::getBounds()
-{
-	return getTransform().transformRect(m_body.getGlobalBounds());
-}
-
 void Rider::draw(sf::RenderTarget& target, sf::RenderStates states) const 
 {
 	sf::Color color = m_body.getFillColor();
@@ -99,8 +148,5 @@ void Rider::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	
 sf::Vector2f Rider::translate(sf::Vector2f point)
 {
-	float rot = getRotation();
-	return sf::Vector2f(
-		point.x * std::cos(Utilise::toRadian(rot)) + point.y * std::sin(Utilise::toRadian(rot)),
-		-point.x * std::sin(Utilise::toRadian(rot)) + point.y * std::cos(Utilise::toRadian(rot)));
+	return getHeading().toLocal(point);
 }
\ No newline at end of file
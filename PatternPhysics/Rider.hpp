@@ -4,7 +4,11 @@
 #include <deque>
 #include <SFML/Graphics.hpp>
 
-class Entity : public sf::Transformable
+#include "Heading.hpp"
+#include "Trace.hpp"
+
+// The rotation is kept as a unit vector, so moving needs no trig
+class Entity
 {
 public:
 	enum SideSteer
@@ -14,7 +18,16 @@ public:
 public:
 	Entity(float jet_strength, float steer_force);
 	void update(sf::Time dt);
-	sf::Vector2f getVelocity();
+	sf::Vector2f getVelocity() const;
+	const sf::Vector2f& getPosition() const;
+	void setPosition(float x, float y);
+	void setPosition(sf::Vector2f position);
+	const Utilise::Heading& getHeading() const;
+	void setHeading(const Utilise::Heading& heading);
+	// Built from the heading, for rendering
+	sf::Transform getTransform() const;
+	// Steer side in the low bits, bit 2 while the thruster is on
+	int getState() const;
 public:
 	// The acceleration ~ force applied to the back
 	// max is 1
@@ -22,13 +35,15 @@ public:
 	float push_acceleration;
 	SideSteer steer;
 	bool thruster;
-	// Value of getRotation but unnormalised
+	// Heading in degree, unnormalised
 	float direction;
 private:
 	// Unit: degree/s
 	float m_steer_value;
 	float m_push_speed;
 	float m_drag_constant;
+	sf::Vector2f m_position;
+	Utilise::Heading m_heading;
 };
 
 class Rider : public Entity, public sf::Drawable
@@ -39,9 +54,15 @@ public:
 	void update(sf::Time dt);
 
 	sf::FloatRect getBounds();
+
+	void record(TraceWriter& trace, std::uint32_t id) const;
+
+	// Moves to a recorded pose, dt after the last one
+	void restore(const TraceEntity& entity, sf::Time dt);
 private:
 	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 	sf::Vector2f translate(sf::Vector2f point);
+	void updateTrail(sf::Time dt);
 protected:
 	mutable sf::RectangleShape m_body;
 private:
@@ -0,0 +1,162 @@
+#ifndef AI_SHARED_ALIGNED_ARRAY
+#define AI_SHARED_ALIGNED_ARRAY
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+// Growable array of trivially copyable values whose storage starts on an
+// Alignment-byte boundary, so SIMD loads on it never straddle cache lines.
+template<typename T, std::size_t Alignment = 32>
+class AlignedArray
+{
+public:
+	AlignedArray()
+		: m_data(nullptr)
+		, m_size(0)
+		, m_capacity(0)
+	{ }
+
+	explicit AlignedArray(std::size_t size)
+		: AlignedArray()
+	{
+		resize(size);
+	}
+
+	AlignedArray(const AlignedArray& other)
+		: AlignedArray()
+	{
+		*this = other;
+	}
+
+	AlignedArray& operator=(const AlignedArray& other)
+	{
+		if (this != &other)
+		{
+			m_size = 0;
+			resize(other.m_size);
+			if (m_size)
+				std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+		}
+		return *this;
+	}
+
+	AlignedArray(AlignedArray&& other)
+		: m_data(other.m_data)
+		, m_size(other.m_size)
+		, m_capacity(other.m_capacity)
+	{
+		other.m_data = nullptr;
+		other.m_size = other.m_capacity = 0;
+	}
+
+	AlignedArray& operator=(AlignedArray&& other)
+	{
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		std::swap(m_capacity, other.m_capacity);
+		return *this;
+	}
+
+	~AlignedArray()
+	{
+		release(m_data);
+	}
+
+	// New elements are zero-initialised, old ones are kept
+	void resize(std::size_t size)
+	{
+		if (size > m_capacity)
+			reserve(std::max(size, 2 * m_capacity));
+		if (size > m_size)
+			std::memset(m_data + m_size, 0, (size - m_size) * sizeof(T));
+		m_size = size;
+	}
+
+	void reserve(std::size_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return;
+		T* data = allocate(capacity);
+		if (m_size)
+			std::memcpy(data, m_data, m_size * sizeof(T));
+		release(m_data);
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+	void push_back(const T& value)
+	{
+		resize(m_size + 1);
+		m_data[m_size - 1] = value;
+	}
+
+	void pop_back()
+	{
+		assert(m_size && "Pop from empty array");
+		m_size--;
+	}
+
+	void clear()
+	{
+		m_size = 0;
+	}
+
+	T& operator[](std::size_t i)
+	{
+		return m_data[i];
+	}
+
+	const T& operator[](std::size_t i) const
+	{
+		return m_data[i];
+	}
+
+	T* data()
+	{
+		return m_data;
+	}
+
+	const T* data() const
+	{
+		return m_data;
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+private:
+	static T* allocate(std::size_t count)
+	{
+		// Over-allocate and keep the original pointer right before the aligned block
+		void* raw = std::malloc(count * sizeof(T) + Alignment + sizeof(void*));
+		if (raw == nullptr)
+			throw std::bad_alloc();
+		std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+		std::uintptr_t aligned = (start + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+		reinterpret_cast<void**>(aligned)[-1] = raw;
+		return reinterpret_cast<T*>(aligned);
+	}
+
+	static void release(T* data)
+	{
+		if (data)
+			std::free(reinterpret_cast<void**>(data)[-1]);
+	}
+private:
+	T* m_data;
+	std::size_t m_size;
+	std::size_t m_capacity;
+};
+
+#endif
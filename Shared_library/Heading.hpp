@@ -0,0 +1,89 @@
+#ifndef AI_SHARED_HEADING
+#define AI_SHARED_HEADING
+
+#include <cmath>
+
+#include <SFML/Graphics.hpp>
+
+#include "Utilise.hpp"
+
+namespace Utilise
+{
+	// Rotation by a fixed angle kept as its matrix, so applying it needs no trig
+	class Rotation
+	{
+	public:
+		explicit Rotation(float degree = 0.f)
+			: m_cos(std::cos(toRadian(degree)))
+			, m_sin(std::sin(toRadian(degree)))
+		{ }
+
+		Rotation inverse() const
+		{
+			Rotation ans;
+			ans.m_cos = m_cos;
+			ans.m_sin = -m_sin;
+			return ans;
+		}
+
+		sf::Vector2f apply(sf::Vector2f vec) const
+		{
+			return sf::Vector2f(vec.x * m_cos - vec.y * m_sin, vec.x * m_sin + vec.y * m_cos);
+		}
+	private:
+		float m_cos;
+		float m_sin;
+	};
+
+	// Orientation stored as the unit vector (cos, sin) of its angle, i.e. the local x axis.
+	// Degrees are only needed to create one and to display it.
+	class Heading
+	{
+	public:
+		explicit Heading(float degree = 0.f)
+			: m_dir(std::cos(toRadian(degree)), std::sin(toRadian(degree)))
+		{ }
+
+		const sf::Vector2f& getDirection() const
+		{
+			return m_dir;
+		}
+
+		void rotate(const Rotation& rotation)
+		{
+			m_dir = rotation.apply(m_dir);
+			// One Newton step back to unit length, enough to stop the drift
+			m_dir *= 1.5f - 0.5f * (m_dir.x * m_dir.x + m_dir.y * m_dir.y);
+		}
+
+		float toDegree() const
+		{
+			return Utilise::toDegree(std::atan2(m_dir.y, m_dir.x));
+		}
+
+		// World vector to the local frame
+		sf::Vector2f toLocal(sf::Vector2f vec) const
+		{
+			return sf::Vector2f(vec.x * m_dir.x + vec.y * m_dir.y, vec.y * m_dir.x - vec.x * m_dir.y);
+		}
+
+		// Local vector to the world frame
+		sf::Vector2f toGlobal(sf::Vector2f vec) const
+		{
+			return sf::Vector2f(vec.x * m_dir.x - vec.y * m_dir.y, vec.x * m_dir.y + vec.y * m_dir.x);
+		}
+
+		// Same as an sf::Transformable at position with this rotation
+		sf::Transform getTransform(sf::Vector2f position) const
+		{
+			return sf::Transform(
+				m_dir.x, -m_dir.y, position.x,
+				m_dir.y, m_dir.x, position.y,
+				0.f, 0.f, 1.f);
+		}
+	private:
+		sf::Vector2f m_dir;
+	};
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "InterceptSolver.hpp"
+#include "Simd.hpp"
+
+#include <cmath>
+
+// With d = target - origin and the quadratic (v.v - s^2) t^2 + 2 (d.v) t + d.d = 0,
+// a = v.v - s^2, b = d.v and c = d.d, the earliest root is c / (sqrt(b^2 - a c) - b).
+// That form has no cancellation when the speeds are close and covers a = 0 too.
+// There is a non negative root only when the discriminant is not negative and the
+// denominator is positive, unless the target is already at the origin.
+
+const float InterceptSolver::NO_SOLUTION = -1.f;
+
+float InterceptSolver::solve(sf::Vector2f origin, float speed, sf::Vector2f target, sf::Vector2f velocity)
+{
+	float dx = target.x - origin.x, dy = target.y - origin.y;
+	float c = dx * dx + dy * dy;
+	if (c == 0.f)
+		return 0.f;
+	float a = velocity.x * velocity.x + velocity.y * velocity.y - speed * speed;
+	float b = dx * velocity.x + dy * velocity.y;
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.f)
+		return NO_SOLUTION;
+	float denominator = std::sqrt(discriminant) - b;
+	if (denominator <= 0.f)
+		return NO_SOLUTION;
+	return c / denominator;
+}
+
+int InterceptSolver::add(sf::Vector2f origin, float speed, sf::Vector2f target, sf::Vector2f velocity)
+{
+	m_origin_x.push_back(origin.x);
+	m_origin_y.push_back(origin.y);
+	m_speed.push_back(speed);
+	m_target_x.push_back(target.x);
+	m_target_y.push_back(target.y);
+	m_velocity_x.push_back(velocity.x);
+	m_velocity_y.push_back(velocity.y);
+	m_time.push_back(NO_SOLUTION);
+	return static_cast<int>(m_time.size()) - 1;
+}
+
+void InterceptSolver::clear()
+{
+	m_origin_x.clear();
+	m_origin_y.clear();
+	m_speed.clear();
+	m_target_x.clear();
+	m_target_y.clear();
+	m_velocity_x.clear();
+	m_velocity_y.clear();
+	m_time.clear();
+}
+
+int InterceptSolver::size() const
+{
+	return static_cast<int>(m_time.size());
+}
+
+void InterceptSolver::solve()
+{
+	int count = size();
+	int i = 0;
+#if defined(AI_SIMD_AVX2)
+	const __m256 zero = _mm256_setzero_ps(), none = _mm256_set1_ps(NO_SOLUTION);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 dx = _mm256_sub_ps(_mm256_load_ps(m_target_x.data() + i), _mm256_load_ps(m_origin_x.data() + i));
+		__m256 dy = _mm256_sub_ps(_mm256_load_ps(m_target_y.data() + i), _mm256_load_ps(m_origin_y.data() + i));
+		__m256 vx = _mm256_load_ps(m_velocity_x.data() + i), vy = _mm256_load_ps(m_velocity_y.data() + i);
+		__m256 s = _mm256_load_ps(m_speed.data() + i);
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 a = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(s, s));
+		__m256 b = _mm256_add_ps(_mm256_mul_ps(dx, vx), _mm256_mul_ps(dy, vy));
+		__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+		__m256 denominator = _mm256_sub_ps(_mm256_sqrt_ps(_mm256_max_ps(discriminant, zero)), b);
+		__m256 valid = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ), _mm256_cmp_ps(denominator, zero, _CMP_GT_OQ));
+		__m256 time = _mm256_blendv_ps(none, _mm256_div_ps(c, denominator), valid);
+		_mm256_store_ps(m_time.data() + i, _mm256_blendv_ps(time, zero, _mm256_cmp_ps(c, zero, _CMP_EQ_OQ)));
+	}
+#elif defined(AI_SIMD_SSE2)
+	const __m128 zero = _mm_setzero_ps(), none = _mm_set1_ps(NO_SOLUTION);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_load_ps(m_target_x.data() + i), _mm_load_ps(m_origin_x.data() + i));
+		__m128 dy = _mm_sub_ps(_mm_load_ps(m_target_y.data() + i), _mm_load_ps(m_origin_y.data() + i));
+		__m128 vx = _mm_load_ps(m_velocity_x.data() + i), vy = _mm_load_ps(m_velocity_y.data() + i);
+		__m128 s = _mm_load_ps(m_speed.data() + i);
+		__m128 c = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 a = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(s, s));
+		__m128 b = _mm_add_ps(_mm_mul_ps(dx, vx), _mm_mul_ps(dy, vy));
+		__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		__m128 denominator = _mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(discriminant, zero)), b);
+		__m128 valid = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmpgt_ps(denominator, zero));
+		__m128 time = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(c, denominator)), _mm_andnot_ps(valid, none));
+		_mm_store_ps(m_time.data() + i, _mm_andnot_ps(_mm_cmpeq_ps(c, zero), time));
+	}
+#endif
+	for (; i < count; i++)
+		m_time[i] = solve(sf::Vector2f(m_origin_x[i], m_origin_y[i]), m_speed[i], sf::Vector2f(m_target_x[i], m_target_y[i]), sf::Vector2f(m_velocity_x[i], m_velocity_y[i]));
+}
+
+bool InterceptSolver::hasSolution(int id) const
+{
+	return m_time[id] >= 0.f;
+}
+
+float InterceptSolver::getTime(int id) const
+{
+	return m_time[id];
+}
+
+sf::Vector2f InterceptSolver::getAimPoint(int id) const
+{
+	sf::Vector2f target(m_target_x[id], m_target_y[id]);
+	if (!hasSolution(id))
+		return target;
+	return target + sf::Vector2f(m_velocity_x[id], m_velocity_y[id]) * m_time[id];
+}
@@ -0,0 +1,47 @@
+#ifndef AI_SHARED_INTERCEPT_SOLVER
+#define AI_SHARED_INTERCEPT_SOLVER
+
+#include <SFML/Graphics.hpp>
+
+#include "AlignedArray.hpp"
+
+// Where a shot or a pursuer leaving origin at a fixed speed meets a target moving at
+// constant velocity. Solves |target + velocity * t - origin| = speed * t in closed form.
+// Requests are kept in packed arrays so a whole batch is solved several at a time.
+class InterceptSolver
+{
+public:
+	// Time of a request that can never meet its target
+	static const float NO_SOLUTION;
+public:
+	// Earliest meeting time, NO_SOLUTION if the target outruns the shot
+	static float solve(sf::Vector2f origin, float speed, sf::Vector2f target, sf::Vector2f velocity);
+
+	// Returns the index of the request
+	int add(sf::Vector2f origin, float speed, sf::Vector2f target, sf::Vector2f velocity);
+
+	void clear();
+
+	int size() const;
+
+	// Solves every request. Uses AVX2 or SSE2 when available.
+	void solve();
+
+	bool hasSolution(int id) const;
+
+	float getTime(int id) const;
+
+	// Meeting point, or where the target is now when there is no solution
+	sf::Vector2f getAimPoint(int id) const;
+private:
+	AlignedArray<float> m_origin_x;
+	AlignedArray<float> m_origin_y;
+	AlignedArray<float> m_speed;
+	AlignedArray<float> m_target_x;
+	AlignedArray<float> m_target_y;
+	AlignedArray<float> m_velocity_x;
+	AlignedArray<float> m_velocity_y;
+	AlignedArray<float> m_time;
+};
+
+#endif
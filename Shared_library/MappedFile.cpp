@@ -0,0 +1,113 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+#if defined(_WIN32)
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+#else
+	, m_descriptor(-1)
+#endif
+{ }
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+#if defined(_WIN32)
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+	m_descriptor = ::open(path.c_str(), O_RDONLY);
+	if (m_descriptor < 0)
+		return false;
+	struct stat info;
+	if (fstat(m_descriptor, &info) != 0 || info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, m_descriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	m_data = static_cast<const unsigned char*>(data);
+	m_size = static_cast<std::size_t>(info.st_size);
+#endif
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr)
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+	if (m_descriptor >= 0)
+		::close(m_descriptor);
+	m_descriptor = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return m_data != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return m_data;
+}
+
+std::size_t MappedFile::size() const
+{
+	return m_size;
+}
@@ -0,0 +1,40 @@
+#ifndef AI_SHARED_MAPPED_FILE
+#define AI_SHARED_MAPPED_FILE
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into memory
+class MappedFile
+{
+public:
+	MappedFile();
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+
+	void close();
+
+	bool isOpen() const;
+
+	const unsigned char* data() const;
+
+	std::size_t size() const;
+private:
+	const unsigned char* m_data;
+	std::size_t m_size;
+#if defined(_WIN32)
+	// HANDLEs, kept as void* so windows.h stays out of the header
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_descriptor;
+#endif
+};
+
+#endif
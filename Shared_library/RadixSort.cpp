@@ -0,0 +1,64 @@
+#include "RadixSort.hpp"
+
+#include <algorithm>
+
+void RadixSort::sort(std::vector<std::uint32_t>& keys, std::vector<std::uint32_t>& values, WorkerPool& pool)
+{
+	int count = static_cast<int>(keys.size());
+	int blocks = std::max(1, std::min(pool.size(), count / MIN_BLOCK));
+	int block_size = (count + blocks - 1) / std::max(1, blocks);
+	m_keys.resize(count);
+	m_values.resize(count);
+	m_offsets.resize(static_cast<std::size_t>(blocks) * RADIX);
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		std::fill(m_offsets.begin(), m_offsets.end(), 0);
+		pool.parallelFor(blocks, 1, [&](int first, int last, int)
+			{
+				for (int b = first; b < last; b++)
+				{
+					int* counts = &m_offsets[b * RADIX];
+					int end = std::min(count, (b + 1) * block_size);
+					for (int i = b * block_size; i < end; i++)
+						counts[(keys[i] >> shift) & (RADIX - 1)]++;
+				}
+			});
+
+		// Digit major, block minor, so equal keys keep their order across blocks
+		bool uniform = false;
+		int sum = 0;
+		for (int d = 0; d < RADIX; d++)
+		{
+			int digit_total = 0;
+			for (int b = 0; b < blocks; b++)
+			{
+				int& slot = m_offsets[b * RADIX + d];
+				int n = slot;
+				slot = sum;
+				sum += n;
+				digit_total += n;
+			}
+			uniform |= digit_total == count;
+		}
+		if (uniform)
+			continue;
+
+		pool.parallelFor(blocks, 1, [&](int first, int last, int)
+			{
+				for (int b = first; b < last; b++)
+				{
+					int* offsets = &m_offsets[b * RADIX];
+					int end = std::min(count, (b + 1) * block_size);
+					for (int i = b * block_size; i < end; i++)
+					{
+						int to = offsets[(keys[i] >> shift) & (RADIX - 1)]++;
+						m_keys[to] = keys[i];
+						m_values[to] = values[i];
+					}
+				}
+			});
+		keys.swap(m_keys);
+		values.swap(m_values);
+	}
+}
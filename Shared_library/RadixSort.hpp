@@ -0,0 +1,30 @@
+#ifndef AI_SHARED_RADIX_SORT
+#define AI_SHARED_RADIX_SORT
+
+#include <cstdint>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+// Stable LSD radix sort of 32-bit keys carrying a 32-bit value, 8 bits per pass.
+// The input is cut into one block per worker. Each pass counts digits per block,
+// then every block scatters to offsets of its own, so the result does not depend
+// on the scheduling. Passes where every key has the same digit are skipped.
+// Scratch buffers are kept between calls.
+class RadixSort
+{
+public:
+	// Sorts keys in place and applies the same permutation to values
+	void sort(std::vector<std::uint32_t>& keys, std::vector<std::uint32_t>& values, WorkerPool& pool);
+private:
+	static const int RADIX = 256;
+	// Below this, a single block is faster than waking the pool
+	static const int MIN_BLOCK = 4096;
+private:
+	std::vector<std::uint32_t> m_keys;
+	std::vector<std::uint32_t> m_values;
+	// RADIX entries per block, counts then scatter offsets
+	std::vector<int> m_offsets;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef AI_SHARED_RANDOM
+#define AI_SHARED_RANDOM
+
+#include <cstdint>
+
+namespace Utilise
+{
+	// Counter-based generator: the n-th value of a stream is a hash of (seed, stream, n),
+	// so any stream can be started anywhere without shared state. Give each thread,
+	// or each spawned entity, its own stream and results do not depend on scheduling.
+	class Random
+	{
+	public:
+		explicit Random(std::uint64_t seed = 0, std::uint64_t stream = 0)
+			: m_key(mix(seed ^ mix(stream + 0x9e3779b97f4a7c15ull)))
+			, m_counter(0)
+		{ }
+
+		// Value number counter of the stream, does not advance it
+		std::uint64_t at(std::uint64_t counter) const
+		{
+			return mix(m_key + counter * 0x9e3779b97f4a7c15ull);
+		}
+
+		std::uint64_t next()
+		{
+			return at(m_counter++);
+		}
+
+		// Uniform in [0, 1)
+		float uniform()
+		{
+			return (next() >> 40) * (1.f / 16777216.f);
+		}
+
+		float uniform(float min, float max)
+		{
+			return min + (max - min) * uniform();
+		}
+
+		// Uniform in [0, bound), bound must be positive
+		int below(int bound)
+		{
+			return static_cast<int>(((next() >> 32) * static_cast<std::uint64_t>(bound)) >> 32);
+		}
+	private:
+		// SplitMix64 finaliser
+		static std::uint64_t mix(std::uint64_t z)
+		{
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+	private:
+		std::uint64_t m_key;
+		std::uint64_t m_counter;
+	};
+}
+
+#endif
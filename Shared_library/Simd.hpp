@@ -0,0 +1,15 @@
+#ifndef AI_SHARED_SIMD
+#define AI_SHARED_SIMD
+
+// Picks the widest instruction set the compiler was told it may use.
+// MSVC only defines __AVX2__ under /arch:AVX2 and always has SSE2 on x64.
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define AI_SIMD_AVX2
+	#define AI_SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define AI_SIMD_SSE2
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+#include "SlotMap.hpp"
+
+namespace
+{
+	const std::uint32_t INDEX_MASK = (1u << SlotMap::INDEX_BITS) - 1;
+	const std::uint32_t GENERATION_MASK = (1u << SlotMap::GENERATION_BITS) - 1;
+}
+
+SlotMap::Handle SlotMap::insert()
+{
+	Handle handle = allocate(static_cast<std::int32_t>(m_dense.size()));
+	if (handle != NONE)
+		m_dense.push_back(handle);
+	return handle;
+}
+
+SlotMap::Handle SlotMap::insertDetached()
+{
+	return allocate(DETACHED);
+}
+
+int SlotMap::erase(Handle handle)
+{
+	int slot = slotOf(handle);
+	if (slot < 0)
+		return -1;
+	int index = m_slots[slot].index;
+	if (index >= 0)
+		removeDense(index);
+	release(static_cast<std::uint32_t>(slot));
+	return index;
+}
+
+int SlotMap::detach(Handle handle)
+{
+	int slot = slotOf(handle);
+	if (slot < 0 || m_slots[slot].index < 0)
+		return -1;
+	int index = m_slots[slot].index;
+	removeDense(index);
+	m_slots[slot].index = DETACHED;
+	return index;
+}
+
+bool SlotMap::attach(Handle handle)
+{
+	int slot = slotOf(handle);
+	if (slot < 0 || m_slots[slot].index != DETACHED)
+		return false;
+	m_slots[slot].index = static_cast<std::int32_t>(m_dense.size());
+	m_dense.push_back(handle);
+	return true;
+}
+
+bool SlotMap::contains(Handle handle) const
+{
+	return slotOf(handle) >= 0;
+}
+
+int SlotMap::indexOf(Handle handle) const
+{
+	int slot = slotOf(handle);
+	return slot < 0 ? -1 : m_slots[slot].index;
+}
+
+SlotMap::Handle SlotMap::handleAt(int index) const
+{
+	return m_dense[index];
+}
+
+void SlotMap::reorder(const std::uint32_t* order)
+{
+	m_scratch.resize(m_dense.size());
+	for (std::size_t i = 0; i < m_dense.size(); i++)
+	{
+		Handle handle = m_dense[order[i]];
+		m_scratch[i] = handle;
+		m_slots[handle & INDEX_MASK].index = static_cast<std::int32_t>(i);
+	}
+	m_dense.swap(m_scratch);
+}
+
+int SlotMap::size() const
+{
+	return static_cast<int>(m_dense.size());
+}
+
+int SlotMap::getSlotCount() const
+{
+	return static_cast<int>(m_slots.size());
+}
+
+SlotMap::Handle SlotMap::handleOfSlot(int slot) const
+{
+	if (m_slots[slot].index == FREE)
+		return NONE;
+	return makeHandle(static_cast<std::uint32_t>(slot), m_slots[slot].generation);
+}
+
+void SlotMap::clear()
+{
+	// Generations are kept, so handles from before the clear stay stale
+	m_free.clear();
+	for (std::size_t i = 0; i < m_slots.size(); i++)
+	{
+		if (m_slots[i].index != FREE)
+			release(static_cast<std::uint32_t>(i));
+		else
+			m_free.push_back(static_cast<std::uint32_t>(i));
+	}
+	m_dense.clear();
+}
+
+SlotMap::Handle SlotMap::allocate(std::int32_t index)
+{
+	std::uint32_t slot;
+	if (m_free.size() < static_cast<std::size_t>(MIN_FREE_SLOTS) && m_slots.size() < static_cast<std::size_t>(MAX_SLOTS))
+	{
+		slot = static_cast<std::uint32_t>(m_slots.size());
+		m_slots.push_back(Slot{ 0, FREE });
+	}
+	else
+	{
+		if (m_free.empty())
+			return NONE;
+		slot = m_free.front();
+		m_free.pop_front();
+	}
+	m_slots[slot].index = index;
+	return makeHandle(slot, m_slots[slot].generation);
+}
+
+void SlotMap::removeDense(int index)
+{
+	Handle last = m_dense.back();
+	m_dense[index] = last;
+	m_slots[last & INDEX_MASK].index = index;
+	m_dense.pop_back();
+}
+
+void SlotMap::release(std::uint32_t slot)
+{
+	m_slots[slot].index = FREE;
+	m_slots[slot].generation = (m_slots[slot].generation + 1) & GENERATION_MASK;
+	m_free.push_back(slot);
+}
+
+SlotMap::Handle SlotMap::makeHandle(std::uint32_t slot, std::uint32_t generation)
+{
+	return (generation << INDEX_BITS) | slot;
+}
+
+int SlotMap::slotOf(Handle handle) const
+{
+	std::uint32_t slot = handle & INDEX_MASK;
+	if (slot >= m_slots.size())
+		return -1;
+	const Slot& s = m_slots[slot];
+	if (s.index == FREE || s.generation != handle >> INDEX_BITS)
+		return -1;
+	return static_cast<int>(slot);
+}
@@ -0,0 +1,106 @@
+#ifndef AI_SHARED_SLOT_MAP
+#define AI_SHARED_SLOT_MAP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Stable 32-bit handles over a dense, swap-removed collection. The elements live in
+// the owner's own arrays, often one per field, indexed [0, size()). The map keeps
+// each handle's dense index in step with them, so the owner only mirrors the moves
+// it reports. A handle carries the generation of its slot: once erased, it stops
+// resolving even after the slot is reused.
+//
+// Generations wrap rather than retire their slot, so the map never runs out of
+// slots under churn and its table stays at the peak element count plus
+// MIN_FREE_SLOTS. The price is that a stale handle resolves again if its slot is
+// reused exactly a multiple of 2^GENERATION_BITS times while the handle is held.
+// Freed slots are reused oldest first from a queue of at least MIN_FREE_SLOTS, so
+// that takes over 2^(2 * GENERATION_BITS), about a million, erasures in between.
+// NONE names the last slot, which is never handed out, so it resolves under no
+// generation.
+class SlotMap
+{
+public:
+	typedef std::uint32_t Handle;
+	// Low bits of a handle index the slot table, high bits hold its generation
+	static const int INDEX_BITS = 22;
+	static const int GENERATION_BITS = 32 - INDEX_BITS;
+	// The last slot index is never handed out, so NONE never resolves
+	static const int MAX_SLOTS = (1 << INDEX_BITS) - 1;
+	static const Handle NONE = 0xffffffffu;
+	// Free slots held back before one is reused, spreading churn over that many slots
+	static const int MIN_FREE_SLOTS = 1 << GENERATION_BITS;
+public:
+	// New handle bound to dense index size(), the owner appends its element.
+	// Returns NONE once MAX_SLOTS handles are in use.
+	Handle insert();
+
+	// New handle with no element, see attach
+	Handle insertDetached();
+
+	// Releases handle. If it had an element, the last one moves into its dense index,
+	// which is returned so the owner can move its own last element likewise.
+	// Returns -1 for a stale handle or one with no element.
+	int erase(Handle handle);
+
+	// Takes the element of handle out of the dense range but keeps the handle valid.
+	// Same return value as erase.
+	int detach(Handle handle);
+
+	// Binds a detached handle to dense index size(), the owner appends its element
+	bool attach(Handle handle);
+
+	bool contains(Handle handle) const;
+
+	// Dense index of handle, -1 when stale or detached
+	int indexOf(Handle handle) const;
+
+	Handle handleAt(int index) const;
+
+	// New dense index i takes the element at order[i], order being a permutation of [0, size())
+	void reorder(const std::uint32_t* order);
+
+	// Live elements
+	int size() const;
+
+	// Slots ever used. Walking them visits handles in a stable order, whatever the
+	// dense order is: see handleOfSlot.
+	int getSlotCount() const;
+
+	// Handle in slot, NONE when the slot is free
+	Handle handleOfSlot(int slot) const;
+
+	void clear();
+private:
+	static const std::int32_t FREE = -2;
+	static const std::int32_t DETACHED = -1;
+
+	struct Slot
+	{
+		std::uint32_t generation;
+		// Dense index, DETACHED or FREE
+		std::int32_t index;
+	};
+private:
+	Handle allocate(std::int32_t index);
+
+	// Removes the dense entry at index by moving the last one into it
+	void removeDense(int index);
+
+	// Bumps the generation of slot and queues it for reuse
+	void release(std::uint32_t slot);
+
+	static Handle makeHandle(std::uint32_t slot, std::uint32_t generation);
+
+	// Slot of a handle that resolves, -1 otherwise
+	int slotOf(Handle handle) const;
+private:
+	std::vector<Slot> m_slots;
+	std::deque<std::uint32_t> m_free;
+	// Handle of every dense index
+	std::vector<Handle> m_dense;
+	std::vector<Handle> m_scratch;
+};
+
+#endif
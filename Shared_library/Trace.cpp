@@ -0,0 +1,407 @@
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const char HEADER_MAGIC[4] = { 'A', 'I', 'T', 'R' };
+	const char INDEX_MAGIC[4] = { 'A', 'I', 'T', 'X' };
+	const std::uint32_t VERSION = 3;
+	const int HEADER_SIZE = 40;
+	const int FOOTER_SIZE = 8;
+	const float POSITION_SCALE = 64.f;
+	const float SPEED_SCALE = 64.f;
+	const float ANGLE_SCALE = 65536.f / 360.f;
+
+	enum Column
+	{
+		ID, X, Y, ANGLE, SPEED, STATE, COLUMN_COUNT
+	};
+
+	void putU32(std::vector<unsigned char>& out, std::uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+
+	void putU64(std::vector<unsigned char>& out, std::uint64_t value)
+	{
+		for (int i = 0; i < 8; i++)
+			out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+
+	void putFloat(std::vector<unsigned char>& out, float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		putU32(out, bits);
+	}
+
+	void putVarint(std::vector<unsigned char>& out, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<unsigned char>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<unsigned char>(value));
+	}
+
+	std::uint32_t getU32(const unsigned char* data)
+	{
+		std::uint32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= static_cast<std::uint32_t>(data[i]) << (8 * i);
+		return value;
+	}
+
+	std::uint64_t getU64(const unsigned char* data)
+	{
+		std::uint64_t value = 0;
+		for (int i = 0; i < 8; i++)
+			value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+		return value;
+	}
+
+	float getFloat(const unsigned char* data)
+	{
+		std::uint32_t bits = getU32(data);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// False if the varint runs past end
+	bool getVarint(const unsigned char*& data, const unsigned char* end, std::uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; data != end && shift < 64; shift += 7)
+		{
+			unsigned char byte = *data++;
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	// Maps signed changes to small unsigned values, 0, -1, 1, -2...
+	std::uint64_t zigzag(std::int64_t value)
+	{
+		return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	}
+
+	std::int64_t unzigzag(std::uint64_t value)
+	{
+		return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+
+	std::int32_t quantise(float value, float scale)
+	{
+		double scaled = std::floor(static_cast<double>(value) * scale + 0.5);
+		return static_cast<std::int32_t>(std::min(2147483647.0, std::max(-2147483648.0, scaled)));
+	}
+}
+
+TraceWriter::TraceWriter(const std::string& path, int entity_count, std::uint64_t seed, sf::Vector2f world_size,
+	int keyframe_interval)
+	: m_file(path, std::ios::binary | std::ios::trunc)
+	, m_entity_count(std::max(0, entity_count))
+	, m_keyframe_interval(std::max(1, keyframe_interval))
+	, m_frame_count(0)
+	, m_pending_frames(0)
+	, m_quit(false)
+	, m_offset(HEADER_SIZE)
+{
+	if (!m_file)
+		return;
+	m_bytes.insert(m_bytes.end(), HEADER_MAGIC, HEADER_MAGIC + 4);
+	putU32(m_bytes, VERSION);
+	putU32(m_bytes, static_cast<std::uint32_t>(m_entity_count));
+	putU32(m_bytes, static_cast<std::uint32_t>(m_keyframe_interval));
+	putFloat(m_bytes, POSITION_SCALE);
+	putFloat(m_bytes, SPEED_SCALE);
+	putU64(m_bytes, seed);
+	putFloat(m_bytes, world_size.x);
+	putFloat(m_bytes, world_size.y);
+	m_file.write(reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size());
+	m_bytes.clear();
+	m_thread = std::thread(&TraceWriter::loop, this);
+}
+
+TraceWriter::~TraceWriter()
+{
+	if (!m_thread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+
+	for (std::uint64_t i : m_index)
+		putU64(m_bytes, i);
+	putU32(m_bytes, static_cast<std::uint32_t>(m_index.size()));
+	m_bytes.insert(m_bytes.end(), INDEX_MAGIC, INDEX_MAGIC + 4);
+	m_file.write(reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size());
+}
+
+bool TraceWriter::isOpen() const
+{
+	return m_thread.joinable();
+}
+
+void TraceWriter::add(std::uint32_t id, sf::Vector2f position, const Utilise::Heading& heading, float speed, int state)
+{
+	std::size_t row = m_frame.size();
+	m_frame.resize(row + COLUMN_COUNT);
+	m_frame[row + ID] = static_cast<std::int32_t>(id);
+	m_frame[row + X] = quantise(position.x, POSITION_SCALE);
+	m_frame[row + Y] = quantise(position.y, POSITION_SCALE);
+	// Wraps to [0, 65536), one turn
+	m_frame[row + ANGLE] = quantise(heading.toDegree(), ANGLE_SCALE) & 0xffff;
+	m_frame[row + SPEED] = quantise(speed, SPEED_SCALE);
+	m_frame[row + STATE] = state;
+}
+
+void TraceWriter::endFrame()
+{
+	if (isOpen())
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			// A stalled disk holds the recording back instead of growing m_pending without bound
+			m_drained.wait(lock, [this] { return m_pending_frames < MAX_PENDING_FRAMES; });
+			m_pending.push_back(static_cast<std::int32_t>(m_frame.size() / COLUMN_COUNT));
+			m_pending.insert(m_pending.end(), m_frame.begin(), m_frame.end());
+			m_pending_frames++;
+		}
+		m_wake.notify_one();
+		m_frame_count++;
+	}
+	m_frame.clear();
+}
+
+int TraceWriter::getFrameCount() const
+{
+	return m_frame_count;
+}
+
+void TraceWriter::loop()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_quit || !m_pending.empty(); });
+			if (m_pending.empty())
+				return;
+			std::swap(m_pending, m_encoding);
+			m_pending_frames = 0;
+		}
+		m_drained.notify_one();
+		for (std::size_t i = 0; i < m_encoding.size(); )
+		{
+			int count = m_encoding[i];
+			encode(&m_encoding[i + 1], count);
+			i += 1 + static_cast<std::size_t>(COLUMN_COUNT) * count;
+		}
+		m_encoding.clear();
+		m_file.write(reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size());
+		m_offset += m_bytes.size();
+		m_bytes.clear();
+	}
+}
+
+void TraceWriter::encode(const std::int32_t* frame, int count)
+{
+	int size = COLUMN_COUNT * count;
+	if (m_index.size() % m_keyframe_interval == 0)
+		m_previous.clear();
+	// Rows the previous frame did not have start from zero, on both sides
+	m_previous.resize(size, 0);
+	m_index.push_back(m_offset + m_bytes.size());
+	putVarint(m_bytes, static_cast<std::uint32_t>(count));
+	for (int column = 0; column < COLUMN_COUNT; column++)
+	{
+		for (int i = column; i < size; i += COLUMN_COUNT)
+		{
+			std::int32_t value = frame[i], previous = m_previous[i];
+			if (column == ID || column == STATE)
+				putVarint(m_bytes, static_cast<std::uint32_t>(value ^ previous));
+			else if (column == ANGLE)
+				// Shortest way around the circle, so a turn through 0 stays small
+				putVarint(m_bytes, zigzag(static_cast<std::int16_t>(static_cast<std::uint16_t>(value - previous))));
+			else
+				putVarint(m_bytes, zigzag(static_cast<std::int64_t>(value) - previous));
+		}
+	}
+	std::copy(frame, frame + size, m_previous.begin());
+}
+
+TraceReader::TraceReader()
+	: m_entity_count(0)
+	, m_keyframe_interval(1)
+	, m_frame_count(0)
+	, m_position_scale(1.f)
+	, m_speed_scale(1.f)
+	, m_seed(0)
+	, m_index(nullptr)
+	, m_current(-1)
+{ }
+
+bool TraceReader::open(const std::string& path)
+{
+	m_frame_count = 0;
+	m_current = -1;
+	if (!m_file.open(path))
+		return false;
+	const unsigned char* data = m_file.data();
+	std::size_t size = m_file.size();
+	if (size < HEADER_SIZE + FOOTER_SIZE
+		|| std::memcmp(data, HEADER_MAGIC, 4) != 0 || getU32(data + 4) != VERSION
+		|| std::memcmp(data + size - 4, INDEX_MAGIC, 4) != 0)
+	{
+		m_file.close();
+		return false;
+	}
+	m_entity_count = static_cast<int>(getU32(data + 8));
+	m_keyframe_interval = std::max(1, static_cast<int>(getU32(data + 12)));
+	m_position_scale = getFloat(data + 16);
+	m_speed_scale = getFloat(data + 20);
+	m_seed = getU64(data + 24);
+	m_world_size = sf::Vector2f(getFloat(data + 32), getFloat(data + 36));
+	std::uint64_t frame_count = getU32(data + size - FOOTER_SIZE);
+	if (frame_count * 8 > size - HEADER_SIZE - FOOTER_SIZE)
+	{
+		m_file.close();
+		return false;
+	}
+	m_frame_count = static_cast<int>(frame_count);
+	m_index = data + size - FOOTER_SIZE - 8 * frame_count;
+	m_values.clear();
+	return true;
+}
+
+int TraceReader::getFrameCount() const
+{
+	return m_frame_count;
+}
+
+int TraceReader::getEntityCount() const
+{
+	return m_entity_count;
+}
+
+std::uint64_t TraceReader::getSeed() const
+{
+	return m_seed;
+}
+
+sf::Vector2f TraceReader::getWorldSize() const
+{
+	return m_world_size;
+}
+
+bool TraceReader::read(int frame, std::vector<TraceEntity>& out)
+{
+	if (frame < 0 || frame >= m_frame_count)
+		return false;
+	if (frame != m_current)
+	{
+		int keyframe = frame - frame % m_keyframe_interval;
+		int first = m_current >= keyframe && m_current < frame ? m_current + 1 : keyframe;
+		for (int i = first; i <= frame; i++)
+			if (!decode(i))
+			{
+				m_current = -1;
+				return false;
+			}
+		m_current = frame;
+	}
+
+	out.resize(m_values.size() / COLUMN_COUNT);
+	for (std::size_t i = 0; i < out.size(); i++)
+	{
+		const std::int32_t* row = m_values.data() + i * COLUMN_COUNT;
+		TraceEntity& entity = out[i];
+		entity.id = static_cast<std::uint32_t>(row[ID]);
+		entity.position = sf::Vector2f(row[X] / m_position_scale, row[Y] / m_position_scale);
+		entity.heading = Utilise::Heading(row[ANGLE] / ANGLE_SCALE);
+		entity.speed = row[SPEED] / m_speed_scale;
+		entity.state = row[STATE];
+	}
+	return true;
+}
+
+bool TraceReader::decode(int frame)
+{
+	if (frame % m_keyframe_interval == 0)
+		m_values.clear();
+	const unsigned char* data = m_file.data() + getU64(m_index + 8 * frame);
+	const unsigned char* end = m_index;
+	if (data < m_file.data() + HEADER_SIZE || data > end)
+		return false;
+	std::uint64_t code;
+	// Every row takes at least one byte per column
+	if (!getVarint(data, end, code) || code > static_cast<std::uint64_t>(end - data) / COLUMN_COUNT)
+		return false;
+	std::size_t size = COLUMN_COUNT * static_cast<std::size_t>(code);
+	m_values.resize(size, 0);
+	for (int column = 0; column < COLUMN_COUNT; column++)
+	{
+		for (std::size_t i = column; i < size; i += COLUMN_COUNT)
+		{
+			std::int32_t& value = m_values[i];
+			if (!getVarint(data, end, code))
+				return false;
+			if (column == ID || column == STATE)
+				value ^= static_cast<std::int32_t>(code);
+			else if (column == ANGLE)
+				value = (value + static_cast<std::int32_t>(unzigzag(code))) & 0xffff;
+			else
+				value = static_cast<std::int32_t>(value + unzigzag(code));
+		}
+	}
+	return true;
+}
+
+TracePlayer::TracePlayer(int frame_count)
+	: m_frame(0)
+	, m_last(std::max(0, frame_count - 1))
+	, m_paused(false)
+{ }
+
+void TracePlayer::processEvent(const sf::Event& e)
+{
+	if (e.type != sf::Event::KeyPressed)
+		return;
+	if (e.key.code == sf::Keyboard::Space)
+		m_paused = !m_paused;
+	else if (e.key.code == sf::Keyboard::Left)
+		m_frame = std::max(0, m_frame - 1);
+	else if (e.key.code == sf::Keyboard::Right)
+		m_frame = std::min(m_last, m_frame + 1);
+}
+
+void TracePlayer::scrub(const sf::Window& window)
+{
+	if (!sf::Mouse::isButtonPressed(sf::Mouse::Left))
+		return;
+	float ratio = sf::Mouse::getPosition(window).x / static_cast<float>(window.getSize().x);
+	m_frame = static_cast<int>(std::min(1.f, std::max(0.f, ratio)) * m_last);
+}
+
+void TracePlayer::advance()
+{
+	if (!m_paused)
+		m_frame = std::min(m_last, m_frame + 1);
+}
+
+int TracePlayer::getFrame() const
+{
+	return m_frame;
+}
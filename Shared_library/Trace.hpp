@@ -0,0 +1,155 @@
+#ifndef AI_SHARED_TRACE
+#define AI_SHARED_TRACE
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Heading.hpp"
+#include "MappedFile.hpp"
+
+// Binary trace of a changing set of entities, one frame per tick.
+//
+// File layout, little-endian:
+//   header  "AITR", version, entity count at the start, keyframe interval, position and
+//           speed scales, seed (u64) and world size of the recorded run
+//   frames  entity count of the frame (varint), then six columns of that many values
+//           each: id, x, y, angle, speed, state. Values are quantised and stored as
+//           varints of their change since the same row of the previous frame, rows it
+//           did not have count as zero. Keyframes, every keyframe interval ticks, are
+//           stored against zero so decoding can start from them.
+//   index   byte offset of every frame (u64), frame count (u32), "AITX"
+struct TraceEntity
+{
+	// Chosen by the recorder, follows the entity when rows shift
+	std::uint32_t id;
+	sf::Vector2f position;
+	Utilise::Heading heading;
+	float speed;
+	int state;
+};
+
+// Quantises frames on the calling thread and hands them to a writer thread,
+// which encodes and writes them while the next frames are recorded.
+class TraceWriter
+{
+public:
+	// entity_count, seed and world_size are stored for the replay to rebuild the same
+	// scene. Frames may hold any number of entities.
+	TraceWriter(const std::string& path, int entity_count, std::uint64_t seed = 0,
+		sf::Vector2f world_size = sf::Vector2f(), int keyframe_interval = 60);
+
+	// Writes the remaining frames and the index
+	~TraceWriter();
+
+	TraceWriter(const TraceWriter&) = delete;
+
+	TraceWriter& operator=(const TraceWriter&) = delete;
+
+	bool isOpen() const;
+
+	// Adds an entity to the frame. Keeping the same order every frame keeps the
+	// changes small, id tells the entities apart when it does not.
+	void add(std::uint32_t id, sf::Vector2f position, const Utilise::Heading& heading, float speed, int state);
+
+	// Queues the frame and starts the next one, empty. Waits for the writer thread
+	// while MAX_PENDING_FRAMES frames are queued.
+	void endFrame();
+
+	int getFrameCount() const;
+private:
+	static const int MAX_PENDING_FRAMES = 8;
+private:
+	void loop();
+
+	void encode(const std::int32_t* frame, int count);
+private:
+	std::ofstream m_file;
+	int m_entity_count;
+	int m_keyframe_interval;
+	// Frame being recorded, one row per entity
+	std::vector<std::int32_t> m_frame;
+	int m_frame_count;
+	// Frames waiting for the writer, each its entity count then its rows.
+	// Swapped with m_encoding under m_mutex.
+	std::vector<std::int32_t> m_pending;
+	int m_pending_frames;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_drained;
+	bool m_quit;
+	// Owned by the writer thread
+	std::vector<std::int32_t> m_encoding;
+	std::vector<std::int32_t> m_previous;
+	std::vector<unsigned char> m_bytes;
+	std::vector<std::uint64_t> m_index;
+	std::uint64_t m_offset;
+};
+
+// Reads a trace through a memory mapping. Any frame can be decoded without replaying
+// the simulation, only the frames since the closest keyframe are decoded.
+class TraceReader
+{
+public:
+	TraceReader();
+
+	bool open(const std::string& path);
+
+	int getFrameCount() const;
+
+	// Entities at the start of the run, frames may hold more or fewer
+	int getEntityCount() const;
+
+	std::uint64_t getSeed() const;
+
+	sf::Vector2f getWorldSize() const;
+
+	// Reading the frame after the last one read decodes that frame only
+	bool read(int frame, std::vector<TraceEntity>& out);
+private:
+	bool decode(int frame);
+private:
+	MappedFile m_file;
+	int m_entity_count;
+	int m_keyframe_interval;
+	int m_frame_count;
+	float m_position_scale;
+	float m_speed_scale;
+	std::uint64_t m_seed;
+	sf::Vector2f m_world_size;
+	const unsigned char* m_index;
+	// Quantised rows of m_current
+	std::vector<std::int32_t> m_values;
+	int m_current;
+};
+
+// Replay controls shared by the demos: Space pauses, Left and Right step one tick,
+// dragging the mouse across the window scrubs through the whole trace
+class TracePlayer
+{
+public:
+	explicit TracePlayer(int frame_count);
+
+	void processEvent(const sf::Event& e);
+
+	// Jumps to the frame under the mouse while the left button is held
+	void scrub(const sf::Window& window);
+
+	// One tick forward unless paused, stops at the last frame
+	void advance();
+
+	int getFrame() const;
+private:
+	int m_frame;
+	int m_last;
+	bool m_paused;
+};
+
+#endif
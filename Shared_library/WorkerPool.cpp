@@ -0,0 +1,89 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(int thread_count)
+	: m_task(nullptr)
+	, m_count(0)
+	, m_grain(1)
+	, m_next(0)
+	, m_busy(0)
+	, m_generation(0)
+	, m_quit(false)
+{
+	if (thread_count <= 0)
+		thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	for (int i = 1; i < thread_count; i++)
+		m_threads.emplace_back(&WorkerPool::loop, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (auto& i : m_threads)
+		i.join();
+}
+
+int WorkerPool::size() const
+{
+	return static_cast<int>(m_threads.size()) + 1;
+}
+
+void WorkerPool::parallelFor(int count, int grain, const Task& task)
+{
+	grain = std::max(1, grain);
+	if (m_threads.empty() || count <= grain)
+	{
+		if (count > 0)
+			task(0, count, 0);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_count = count;
+		m_grain = grain;
+		m_next = 0;
+		m_busy = static_cast<int>(m_threads.size());
+		m_generation++;
+	}
+	m_wake.notify_all();
+	runChunks(0);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_busy == 0; });
+	m_task = nullptr;
+}
+
+void WorkerPool::loop(int worker)
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+		runChunks(worker);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+			m_done.notify_one();
+	}
+}
+
+void WorkerPool::runChunks(int worker)
+{
+	while (true)
+	{
+		int first = m_next.fetch_add(m_grain);
+		if (first >= m_count)
+			return;
+		(*m_task)(first, std::min(first + m_grain, m_count), worker);
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef AI_SHARED_WORKER_POOL
+#define AI_SHARED_WORKER_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads that split index ranges between them.
+// The calling thread takes part in the work, so a pool of size 1 owns no thread.
+class WorkerPool
+{
+public:
+	// Called with [first, last) and the index of the worker running it, in [0, size())
+	typedef std::function<void(int first, int last, int worker)> Task;
+public:
+	// thread_count <= 0 uses every hardware thread
+	explicit WorkerPool(int thread_count = 0);
+
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	int size() const;
+
+	// Runs task over [0, count) in chunks of grain indices and returns once all are done
+	void parallelFor(int count, int grain, const Task& task);
+private:
+	void loop(int worker);
+
+	void runChunks(int worker);
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	const Task* m_task;
+	int m_count;
+	int m_grain;
+	std::atomic<int> m_next;
+	int m_busy;
+	unsigned int m_generation;
+	bool m_quit;
+};
+
+#endif
@@ -1,14 +1,27 @@
+// Usage: Steering [--record FILE] [--replay FILE]
+// --record writes a trace of the rider and the chaser to FILE.
+// --replay plays FILE back without simulating: Space pauses, Left and Right step,
+// dragging the mouse across the window scrubs through the whole trace.
+
 #include <cmath>
 #include <deque>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include <SFML/Graphics.hpp>
 
 #include "Utilise.hpp"
+#include "Heading.hpp"
+#include "InterceptSolver.hpp"
+#include "Trace.hpp"
 
 const float SCREEN_SIZE = 1000.f;
 
-class Entity : public sf::Transformable
+// The rotation is kept as a unit vector and turned by a rotation matrix
+// cached for the current time step, so moving needs no trig.
+class Entity
 {
 public:
 	enum SideSteer
@@ -24,27 +37,66 @@ public:
 		, m_drag_constant(0.05f)
 	{
 		setPosition(SCREEN_SIZE / 2.f, SCREEN_SIZE / 2.f);
-		//setRotation(-90);
+		//setHeading(Utilise::Heading(-90));
 	}
 
 	void update(sf::Time dt)
 	{
+		if (dt != m_steer_dt)
+		{
+			m_steer_dt = dt;
+			m_steer_rotation = Utilise::Rotation(abs(m_steer_value) * dt.asSeconds());
+		}
 		if (steer == LEFT)
-			rotate(-abs(m_steer_value) * dt.asSeconds());
+			m_heading.rotate(m_steer_rotation.inverse());
 		if (steer == RIGHT)
-			rotate(abs(m_steer_value) * dt.asSeconds());
+			m_heading.rotate(m_steer_rotation);
 		m_push_speed += push_acceleration * dt.asSeconds();
 		m_push_speed += (-m_drag_constant * m_push_speed * m_push_speed) * dt.asSeconds();
 		m_push_speed = std::max(0.f, m_push_speed);
-		sf::Vector2f velocity(m_push_speed * std::cos(Utilise::toRadian(getRotation())),
-							  m_push_speed * std::sin(Utilise::toRadian(getRotation())));
-		move(velocity * dt.asSeconds());
+		m_position += getVelocity() * dt.asSeconds();
+	}
+
+	sf::Vector2f getVelocity() const
+	{
+		return m_push_speed * m_heading.getDirection();
+	}
+
+	const sf::Vector2f& getPosition() const
+	{
+		return m_position;
+	}
+
+	void setPosition(float x, float y)
+	{
+		m_position = sf::Vector2f(x, y);
+	}
+
+	void setPosition(sf::Vector2f position)
+	{
+		m_position = position;
+	}
+
+	const Utilise::Heading& getHeading() const
+	{
+		return m_heading;
+	}
+
+	void setHeading(const Utilise::Heading& heading)
+	{
+		m_heading = heading;
 	}
 
-	sf::Vector2f getVelocity()
+	// Built from the heading, for rendering
+	sf::Transform getTransform() const
 	{
-		return sf::Vector2f(m_push_speed * std::cos(Utilise::toRadian(getRotation())),
-							m_push_speed * std::sin(Utilise::toRadian(getRotation())));
+		return m_heading.getTransform(m_position);
+	}
+
+	// Steer side in the low bits, bit 2 while pushing
+	int getState() const
+	{
+		return static_cast<int>(steer) | (push_acceleration > 0.f ? 4 : 0);
 	}
 public:
 	// The acceleration ~ force applied to the back
@@ -55,6 +107,11 @@ private:
 	float m_steer_value;
 	float m_push_speed;
 	float m_drag_constant;
+	sf::Vector2f m_position;
+	Utilise::Heading m_heading;
+	// Turn applied by one RIGHT step of m_steer_dt
+	Utilise::Rotation m_steer_rotation;
+	sf::Time m_steer_dt;
 };
 
 class Rider : public Entity, public sf::Drawable
@@ -98,7 +155,29 @@ public:
 		pos.x = std::max(std::min(pos.x, SCREEN_SIZE - 10.f), 10.f);
 		pos.y = std::max(std::min(pos.y, SCREEN_SIZE - 10.f), 10.f);
 		setPosition(pos);
+		updateTrail(dt);
+	}
+
+	sf::FloatRect getBounds()
+	{
+		return getTransform().transformRect(m_body.getGlobalBounds());
+	}
+
+	void record(TraceWriter& trace, std::uint32_t id) const
+	{
+		trace.add(id, getPosition(), getHeading(), Utilise::lengthOf(getVelocity()), getState());
+	}
 
+	// Moves to a recorded pose, dt after the last one
+	void restore(const TraceEntity& entity, sf::Time dt)
+	{
+		setPosition(entity.position);
+		setHeading(entity.heading);
+		updateTrail(dt);
+	}
+private:
+	void updateTrail(sf::Time dt)
+	{
 		m_elapsed_time += dt;
 		while (m_elapsed_time >= m_image_interval)
 		{
@@ -108,11 +187,6 @@ public:
 		}
 	}
 
-	sf::FloatRect getBounds()
-	{
-		return getTransform().transformRect(m_body.getGlobalBounds());
-	}
-private:
 	void draw(sf::RenderTarget& target, sf::RenderStates states) const override
 	{
 		sf::Color color = m_body.getFillColor();
@@ -197,11 +271,11 @@ public:
 			dis = m_prey->getPosition() - getPosition();
 		else
 		{
-			float rela_speed = Utilise::lengthOf(getVelocity() - m_prey->getVelocity());
-			float rela_dis = Utilise::lengthOf(getPosition() - m_prey->getPosition());
-			rela_speed += 1.f;
-			float time_to_intercept = rela_dis / rela_speed;
-			m_intercept_point = m_prey->getPosition() + m_prey->getVelocity() * time_to_intercept;
+			// Too slow to catch the prey yet, head straight for it then
+			float time_to_intercept = InterceptSolver::solve(getPosition(), Utilise::lengthOf(getVelocity()), m_prey->getPosition(), m_prey->getVelocity());
+			m_intercept_point = m_prey->getPosition();
+			if (time_to_intercept >= 0.f)
+				m_intercept_point += m_prey->getVelocity() * time_to_intercept;
 			dis = m_intercept_point - getPosition();
 			m_cursor.setPosition(m_intercept_point);
 		}
@@ -219,10 +293,7 @@ public:
 private:
 	sf::Vector2f translate(sf::Vector2f point)
 	{
-		float rot = getRotation();
-		return sf::Vector2f(
-			point.x * std::cos(Utilise::toRadian(rot)) + point.y * std::sin(Utilise::toRadian(rot)),
-			point.y * std::cos(Utilise::toRadian(rot)) - point.x * std::sin(Utilise::toRadian(rot)));
+		return getHeading().toLocal(point);
 	}
 	
 	void draw(sf::RenderTarget& target, sf::RenderStates states) const override
@@ -239,8 +310,71 @@ private:
 	bool m_show_cursor;
 };
 
-int main()
+int replay(const std::string& path)
+{
+	TraceReader trace;
+	if (!trace.open(path) || trace.getFrameCount() == 0 || trace.getEntityCount() != 2)
+	{
+		std::cerr << "Cannot read trace " << path << "\n";
+		return 1;
+	}
+	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
+	sf::Clock clock;
+	sf::Time elapsed = clock.restart();
+	sf::Time TPF = sf::seconds(1.f / 60);
+
+	Rider bao(1200, 150);
+	Chaser killer(&bao, 900, 150);
+	std::vector<TraceEntity> frame;
+	TracePlayer player(trace.getFrameCount());
+	int shown = -1;
+	while (win.isOpen())
+	{
+		elapsed += clock.restart();
+		sf::Event e;
+		while (win.pollEvent(e))
+		{
+			if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::Escape)
+				win.close();
+			player.processEvent(e);
+		}
+		player.scrub(win);
+		while (elapsed >= TPF)
+		{
+			elapsed -= TPF;
+			player.advance();
+		}
+		if (player.getFrame() != shown && trace.read(player.getFrame(), frame))
+		{
+			shown = player.getFrame();
+			for (const TraceEntity& entity : frame)
+			{
+				if (entity.id == 0)
+					bao.restore(entity, TPF);
+				else
+					killer.restore(entity, TPF);
+			}
+		}
+		win.clear();
+		win.draw(bao);
+		win.draw(killer);
+		win.display();
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
 {
+	std::string record_path;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string name = argv[i];
+		if (name == "--replay")
+			return replay(argv[i + 1]);
+		if (name == "--record")
+			record_path = argv[i + 1];
+	}
+
 	sf::RenderWindow win(sf::VideoMode(1000, 1000), "HI", sf::Style::None);
 	sf::Clock clock;
 	sf::Time elapsed = clock.restart();
@@ -251,6 +385,9 @@ int main()
 	bao.setPosition(300, 300);
 	Chaser killer(&bao, 900, 150);
 	killer.setPosition(sf::Vector2f());
+	std::unique_ptr<TraceWriter> trace;
+	if (!record_path.empty())
+		trace = std::make_unique<TraceWriter>(record_path, 2, 0, sf::Vector2f(SCREEN_SIZE, SCREEN_SIZE));
 
 	while (win.isOpen())
 	{
@@ -270,6 +407,12 @@ int main()
 			bao.processInput(TPF);
 			bao.update(TPF);
 			killer.update(TPF);
+			if (trace)
+			{
+				bao.record(*trace, 0);
+				killer.record(*trace, 1);
+				trace->endFrame();
+			}
 		}
 		win.clear();
 		win.draw(bao);